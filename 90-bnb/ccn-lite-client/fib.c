@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Longest prefix match forwarding table
+ *
+ * @}
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "fib.h"
+
+/* only fibtest uses the table, see RIOT_CCN_TESTS in the Makefile */
+#if RIOT_CCN_TESTS
+
+/* next component of a name, returns its length and 0 at the end */
+static int fib_next_comp(const char **name, const char **comp)
+{
+    const char *p = *name;
+
+    while (*p == '/') {
+        p++;
+    }
+    *comp = p;
+    while (*p && *p != '/') {
+        p++;
+    }
+    *name = p;
+    return p - *comp;
+}
+
+#ifndef FIB_TRIE
+
+typedef struct {
+    char prefix[FIB_PREFIX_LEN];    /* components separated by '/' */
+    uint8_t comps;
+    int16_t face;
+} fib_entry_t;
+
+static fib_entry_t fib[FIB_MAX_ENTRIES];
+static unsigned fib_entries;
+
+const char *fib_backend(void)
+{
+    return "list";
+}
+
+void fib_clear(void)
+{
+    fib_entries = 0;
+}
+
+/* number of components of the prefix if it is one of the name, else -1 */
+static int fib_match(const fib_entry_t *e, const char *name)
+{
+    const char *p = e->prefix;
+    const char *pc, *nc;
+    int plen, nlen;
+
+    for (int i = 0; i < e->comps; i++) {
+        plen = fib_next_comp(&p, &pc);
+        nlen = fib_next_comp(&name, &nc);
+        if (plen != nlen || memcmp(pc, nc, plen) != 0) {
+            return -1;
+        }
+    }
+    return e->comps;
+}
+
+int fib_add(const char *prefix, int face)
+{
+    fib_entry_t e;
+    const char *comp;
+    int len, pos = 0;
+
+    e.comps = 0;
+    e.face = face;
+    while ((len = fib_next_comp(&prefix, &comp)) > 0) {
+        if (e.comps == FIB_MAX_COMPS || len > FIB_COMP_LEN
+            || pos + len + 1 >= FIB_PREFIX_LEN) {
+            return -1;
+        }
+        e.prefix[pos++] = '/';
+        memcpy(e.prefix + pos, comp, len);
+        pos += len;
+        e.comps++;
+    }
+    e.prefix[pos] = '\0';
+
+    for (unsigned i = 0; i < fib_entries; i++) {
+        if (strcmp(fib[i].prefix, e.prefix) == 0) {
+            fib[i].face = face;
+            return 0;
+        }
+    }
+    if (fib_entries == FIB_MAX_ENTRIES) {
+        return -1;
+    }
+    fib[fib_entries++] = e;
+    return 0;
+}
+
+int fib_lookup(const char *name)
+{
+    int face = FIB_NO_MATCH;
+    int best = -1;
+
+    for (unsigned i = 0; i < fib_entries; i++) {
+        int comps = fib_match(&fib[i], name);
+        if (comps > best) {
+            best = comps;
+            face = fib[i].face;
+        }
+    }
+    return face;
+}
+
+void fib_stats(fib_stats_t *stats)
+{
+    stats->entries = fib_entries;
+    stats->nodes = 0;
+    stats->bytes = fib_entries * sizeof(fib_entry_t);
+}
+
+#else /* FIB_TRIE */
+
+/* a prefix of FIB_MAX_COMPS components takes as many nodes, plus the root,
+ * so that the table never runs out of nodes before it has FIB_MAX_ENTRIES
+ * prefixes */
+#define FIB_TRIE_NODES      (FIB_MAX_ENTRIES * FIB_MAX_COMPS + 1)
+/* at most half full, so probe sequences stay short, a power of two */
+#define FIB_TRIE_SLOTS      (4096)
+
+#if FIB_TRIE_SLOTS < 2 * (FIB_TRIE_NODES - 1) || (FIB_TRIE_SLOTS & (FIB_TRIE_SLOTS - 1))
+#error "FIB_TRIE_SLOTS must be a power of two, at least twice the nodes below the root"
+#endif
+
+typedef struct {
+    uint16_t parent;
+    uint8_t len;
+    int16_t face;           /* FIB_NO_MATCH if no prefix ends here */
+    char comp[FIB_COMP_LEN];
+} fib_node_t;
+
+/* node 0 is the root, i.e. the empty prefix */
+static fib_node_t node[FIB_TRIE_NODES] = { { .face = FIB_NO_MATCH } };
+static unsigned fib_nodes = 1;
+static unsigned fib_entries;
+
+/* node of each (parent, component) edge, 0 marks a free slot */
+static uint16_t slot[FIB_TRIE_SLOTS];
+
+const char *fib_backend(void)
+{
+    return "trie";
+}
+
+void fib_clear(void)
+{
+    memset(slot, 0, sizeof(slot));
+    node[0].face = FIB_NO_MATCH;
+    fib_nodes = 1;
+    fib_entries = 0;
+}
+
+static unsigned fib_hash(unsigned parent, const char *comp, int len)
+{
+    uint32_t h = 5381 + parent;
+
+    while (len--) {
+        h = (h << 5) + h + (uint8_t) *comp++;
+    }
+    return h & (FIB_TRIE_SLOTS - 1);
+}
+
+/* child of a node, created if asked to, 0 if there is none */
+static unsigned fib_child(unsigned parent, const char *comp, int len, int create)
+{
+    unsigned h = fib_hash(parent, comp, len);
+
+    while (slot[h]) {
+        fib_node_t *n = &node[slot[h]];
+        if (n->parent == parent && n->len == len && memcmp(n->comp, comp, len) == 0) {
+            return slot[h];
+        }
+        h = (h + 1) & (FIB_TRIE_SLOTS - 1);
+    }
+
+    if (!create || fib_nodes == FIB_TRIE_NODES) {
+        return 0;
+    }
+
+    fib_node_t *n = &node[fib_nodes];
+    n->parent = parent;
+    n->len = len;
+    n->face = FIB_NO_MATCH;
+    memcpy(n->comp, comp, len);
+    slot[h] = fib_nodes;
+    return fib_nodes++;
+}
+
+int fib_add(const char *prefix, int face)
+{
+    const char *p = prefix;
+    const char *comp;
+    int len, comps = 0;
+    unsigned n = 0;
+
+    while ((len = fib_next_comp(&p, &comp)) > 0) {
+        if (++comps > FIB_MAX_COMPS || len > FIB_COMP_LEN) {
+            return -1;
+        }
+    }
+
+    while ((len = fib_next_comp(&prefix, &comp)) > 0) {
+        n = fib_child(n, comp, len, 1);
+        if (!n) {
+            return -1;
+        }
+    }
+
+    if (node[n].face == FIB_NO_MATCH) {
+        if (fib_entries == FIB_MAX_ENTRIES) {
+            return -1;
+        }
+        fib_entries++;
+    }
+    node[n].face = face;
+    return 0;
+}
+
+int fib_lookup(const char *name)
+{
+    const char *comp;
+    int len;
+    unsigned n = 0;
+    int face = node[0].face;
+
+    while ((len = fib_next_comp(&name, &comp)) > 0 && len <= FIB_COMP_LEN) {
+        n = fib_child(n, comp, len, 0);
+        if (!n) {
+            break;
+        }
+        if (node[n].face != FIB_NO_MATCH) {
+            face = node[n].face;
+        }
+    }
+    return face;
+}
+
+void fib_stats(fib_stats_t *stats)
+{
+    stats->entries = fib_entries;
+    stats->nodes = fib_nodes;
+    stats->bytes = sizeof(node) + sizeof(slot);
+}
+
+#endif /* FIB_TRIE */
+
+#endif /* RIOT_CCN_TESTS */
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Longest prefix match forwarding table
+ *
+ * Maps name prefixes to faces. Two implementations are available, chosen
+ * at build time with FIB=list or FIB=trie (see the Makefile):
+ *
+ *  - list: an array of prefixes that is searched as a whole on every
+ *          lookup, like the FIB of the relay. Cheap in memory, the lookup
+ *          cost grows with the number of prefixes.
+ *  - trie: a trie of name components, the children of a node are found in
+ *          a hash table. The lookup cost depends on the depth of the name
+ *          only, not on the number of prefixes.
+ *
+ * Prefixes and names are compared component by component, so /riot/te
+ * is no prefix of /riot/test.
+ *
+ * @}
+ */
+
+#ifndef FIB_H
+#define FIB_H
+
+#define FIB_MAX_ENTRIES     (256)
+#define FIB_MAX_COMPS       (8)     /**< components of a prefix */
+#define FIB_COMP_LEN        (16)    /**< characters of a prefix component */
+#define FIB_PREFIX_LEN      (64)    /**< characters of a prefix, list only */
+
+#define FIB_NO_MATCH        (-1)
+
+typedef struct {
+    unsigned entries;       /**< prefixes in the table */
+    unsigned nodes;         /**< trie nodes in use, including the root */
+    unsigned bytes;         /**< memory the table takes, all of it is
+                                 static for the trie */
+} fib_stats_t;
+
+/**
+ * @brief name of the implementation, "list" or "trie"
+ */
+const char *fib_backend(void);
+
+/**
+ * @brief remove all prefixes
+ */
+void fib_clear(void);
+
+/**
+ * @brief add a prefix, or change the face of a known one
+ *
+ * @return 0 on success, -1 if the table is full or the prefix too long
+ */
+int fib_add(const char *prefix, int face);
+
+/**
+ * @brief face of the longest prefix of a name
+ *
+ * @return the face or FIB_NO_MATCH
+ */
+int fib_lookup(const char *name);
+
+void fib_stats(fib_stats_t *stats);
+
+#endif /* FIB_H */
@@ -0,0 +1,366 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief FIB benchmark for the ccn-lite relay and fib.h
+ *
+ * `fibtest relay` registers /riot/test/fib/<i>/ with the relay until it
+ * refuses or FIB_BENCH_MAX prefixes are in. Whenever the FIB reaches one
+ * of the sizes below, it prints the latency and throughput of the last
+ * registrations and times interests that
+ *
+ *  - hit:  match one of the prefixes and are forwarded to its face
+ *  - miss: match none of them, so the whole FIB is searched
+ *
+ * Like pittest, this relies on the relay running at a higher priority than
+ * the shell. On native, the heap the relay allocated for the registrations
+ * is reported as memory per entry.
+ *
+ * Every interest also costs parsing and a PIT entry, which has nothing to
+ * do with the FIB. Before the first registration, the same number of
+ * interests is timed with no prefix of the benchmark in the FIB. This base
+ * is subtracted from the mean of the hits and misses of every size. The
+ * interests are not answered, so after each size the benchmark waits
+ * FIB_BENCH_EXPIRY_WAIT for their PIT entries to time out, and every size
+ * starts out with the PIT the base was timed with.
+ *
+ * `fibtest local` fills the FIB of fib.h with as many prefixes and prints
+ * the mean cost of adding a prefix, which includes formatting it, and of
+ * hit and miss lookups, together with the memory the table takes. Build
+ * with FIB=list and FIB=trie to compare both implementations.
+ *
+ * Output is CSV:
+ *
+ *      csv,fib,<base|reg|hit|miss>,<size>,<ops per s>,<histogram, see hist.h>
+ *      csv,fib,net,<hit|miss>,<size>,<mean ns above base>
+ *      csv,fib,mem,relay,<size>,<bytes>,<bytes per entry>
+ *      csv,fib,local,<list|trie>,<size>,<add ns>,<hit ns>,<miss ns>,<bytes>,<bytes per entry>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#ifdef BOARD_NATIVE
+#include <malloc.h>
+#endif
+
+#include "msg.h"
+#include "vtimer.h"
+#include "random.h"
+
+#include "ccn_lite/ccnl-riot.h"
+#include "ccn_lite/util/ccnl-riot-client.h"
+
+#include "hist.h"
+#include "fib.h"
+#include "fibbench.h"
+
+#if RIOT_CCN_TESTS
+
+#ifndef FIB_BENCH_MAX
+#define FIB_BENCH_MAX           (1000)
+#endif
+#define FIB_BENCH_LOOKUPS       (50)
+#define FIB_BENCH_FACE          "42"
+#define FIB_BENCH_REG_OK        "prefixreg cmd worked"
+
+/* the relay gives up on an interest after a few retransmissions */
+#ifndef FIB_BENCH_EXPIRY_WAIT
+#define FIB_BENCH_EXPIRY_WAIT   (15 * 1000 * 1000U)
+#endif
+#define FIB_BENCH_POLL          (100 * 1000U)
+
+/* local lookups are too fast to be timed one by one */
+#define FIB_BENCH_LOCAL_LOOKUPS (1000)
+#define FIB_BENCH_LOCAL_NAMES   (64)
+#define FIB_BENCH_NAME_LEN      (32)
+
+static const unsigned sweep_size[] = { 10, 50, 100, 200, 400, 800 };
+static const unsigned sweep_local[] = { 10, 50, 100, 200, FIB_MAX_ENTRIES };
+
+#define SWEEP(a) (sizeof(a) / sizeof(a[0]))
+
+static kernel_pid_t relay;
+static unsigned seq;
+
+static unsigned char pkt[PAYLOAD_SIZE];
+static unsigned char reply[PAYLOAD_SIZE];
+static riot_ccnl_msg_t rmsg;
+
+static hist_t h_reg;
+static hist_t h_hit;
+static hist_t h_miss;
+static hist_t h_base;
+
+static char hit_name[FIB_BENCH_LOCAL_NAMES][FIB_BENCH_NAME_LEN];
+static char miss_name[FIB_BENCH_LOCAL_NAMES][FIB_BENCH_NAME_LEN];
+
+static uint32_t bench_elapsed(timex_t start)
+{
+    timex_t now;
+
+    vtimer_now(&now);
+    return timex_uint64(timex_sub(now, start));
+}
+
+static uint32_t bench_rate(const hist_t *h, uint32_t us)
+{
+    return us ? (uint32_t)((uint64_t) h->count * 1000000 / us) : 0;
+}
+
+static void bench_print(const char *op, unsigned size, uint32_t us, const hist_t *h)
+{
+    printf("csv,fib,%s,%u,%" PRIu32 ",", op, size, bench_rate(h, us));
+    hist_print_csv(h);
+}
+
+static size_t heap_used(void)
+{
+#ifdef BOARD_NATIVE
+    /* mallinfo() is deprecated and its int fields wrap past 2 GB */
+#if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33)
+    return mallinfo2().uordblks;
+#else
+    return mallinfo().uordblks;
+#endif
+#else
+    return 0;
+#endif
+}
+
+/* replies and NACKs end up in the shell's queue, which must not fill up */
+static void bench_drain(void)
+{
+    msg_t m;
+
+    while (msg_try_receive(&m) == 1) {
+        if (m.type == CCNL_RIOT_MSG) {
+            ccnl_free(m.content.ptr);
+        }
+    }
+}
+
+/* let the PIT entries of unanswered interests time out */
+static void bench_expire(void)
+{
+    for (uint32_t t = 0; t < FIB_BENCH_EXPIRY_WAIT; t += FIB_BENCH_POLL) {
+        vtimer_usleep(FIB_BENCH_POLL);
+        bench_drain();
+    }
+}
+
+static int32_t bench_mean_ns(const hist_t *h)
+{
+    return h->count ? (int32_t)(h->sum * 1000 / h->count) : 0;
+}
+
+static void bench_print_net(const char *op, unsigned size, const hist_t *h)
+{
+    printf("csv,fib,net,%s,%u,%" PRIi32 "\n", op, size,
+           bench_mean_ns(h) - bench_mean_ns(&h_base));
+}
+
+static void bench_interest(char **name, hist_t *h)
+{
+    msg_t m;
+    timex_t start;
+    unsigned int nonce = genrand_uint32();
+
+    rmsg.payload = pkt;
+    rmsg.size = mkInterest(name, &nonce, pkt);
+    m.type = CCNL_RIOT_MSG;
+    m.content.ptr = (char *) &rmsg;
+
+    vtimer_now(&start);
+    msg_send(&m, relay);
+    hist_add(h, bench_elapsed(start));
+
+    bench_drain();
+}
+
+/* interests with no prefix of the benchmark in the FIB */
+static void bench_base(void)
+{
+    char nr[12];
+    char bench[] = "bench", base[] = "base";
+    char *comps[] = { bench, base, nr, NULL };
+    timex_t start;
+
+    hist_reset(&h_base);
+    vtimer_now(&start);
+    for (unsigned i = 0; i < FIB_BENCH_LOOKUPS; i++) {
+        snprintf(nr, sizeof(nr), "%u", seq++);
+        bench_interest(comps, &h_base);
+    }
+    bench_print("base", 0, bench_elapsed(start), &h_base);
+    bench_expire();
+}
+
+/* every interest gets a name of its own, so none is aggregated in the PIT */
+static void bench_lookups(unsigned size)
+{
+    char idx[12], nr[12];
+    char riot[] = "riot", test[] = "test", fib[] = "fib";
+    char bench[] = "bench", miss[] = "miss";
+    char *hit_comps[] = { riot, test, fib, idx, nr, NULL };
+    char *miss_comps[] = { bench, miss, nr, NULL };
+    timex_t start;
+    uint32_t us;
+
+    hist_reset(&h_hit);
+    vtimer_now(&start);
+    for (unsigned i = 0; i < FIB_BENCH_LOOKUPS; i++) {
+        snprintf(idx, sizeof(idx), "%" PRIu32, genrand_uint32() % size);
+        snprintf(nr, sizeof(nr), "%u", seq++);
+        bench_interest(hit_comps, &h_hit);
+    }
+    us = bench_elapsed(start);
+    bench_print("hit", size, us, &h_hit);
+
+    hist_reset(&h_miss);
+    vtimer_now(&start);
+    for (unsigned i = 0; i < FIB_BENCH_LOOKUPS; i++) {
+        snprintf(nr, sizeof(nr), "%u", seq++);
+        bench_interest(miss_comps, &h_miss);
+    }
+    us = bench_elapsed(start);
+    bench_print("miss", size, us, &h_miss);
+
+    bench_print_net("hit", size, &h_hit);
+    bench_print_net("miss", size, &h_miss);
+    bench_expire();
+}
+
+static void bench_relay(void)
+{
+    char type[] = "newTRANSface";
+    char face[] = FIB_BENCH_FACE;
+    char prefix[PAYLOAD_SIZE];
+    unsigned n = 0, next = 0;
+    size_t heap = 0;
+    timex_t batch, start;
+
+    riot_new_face(relay, type, face, reply);
+
+    printf("csv,fib,op,size,ops_per_s,");
+    hist_print_csv_header();
+    bench_base();
+
+    hist_reset(&h_reg);
+    vtimer_now(&batch);
+    while (n < FIB_BENCH_MAX) {
+        snprintf(prefix, sizeof(prefix), "/riot/test/fib/%u/", n);
+
+        /* per call, so that whatever the relay frees in between is not
+         * counted */
+        size_t before = heap_used();
+        vtimer_now(&start);
+        riot_register_prefix(relay, prefix, face, reply);
+        hist_add(&h_reg, bench_elapsed(start));
+        heap += heap_used() - before;
+
+        if (strcmp((const char *) reply, FIB_BENCH_REG_OK) != 0) {
+            printf("# relay refused prefix %u: '%s'\n", n, reply);
+            break;
+        }
+        n++;
+
+        if (next < SWEEP(sweep_size) && n == sweep_size[next]) {
+            bench_print("reg", n, bench_elapsed(batch), &h_reg);
+            bench_lookups(n);
+            hist_reset(&h_reg);
+            vtimer_now(&batch);
+            next++;
+        }
+    }
+
+    /* the last size of the sweep is where the relay or FIB_BENCH_MAX stopped */
+    if (n && (next == 0 || n != sweep_size[next - 1])) {
+        bench_print("reg", n, bench_elapsed(batch), &h_reg);
+        bench_lookups(n);
+    }
+
+#ifdef BOARD_NATIVE
+    if (n) {
+        printf("csv,fib,mem,relay,%u,%u,%u\n", n, (unsigned) heap, (unsigned)(heap / n));
+    }
+#else
+    (void) heap;
+#endif
+}
+
+static void bench_local(void)
+{
+    char prefix[FIB_BENCH_NAME_LEN];
+    fib_stats_t stats;
+    timex_t start;
+    uint32_t add, hit, miss;
+    volatile int face;
+
+    puts("csv,fib,local,backend,size,add_ns,hit_ns,miss_ns,bytes,bytes_per_entry");
+    for (unsigned s = 0; s < SWEEP(sweep_local); s++) {
+        unsigned size = sweep_local[s];
+
+        fib_clear();
+        vtimer_now(&start);
+        for (unsigned i = 0; i < size; i++) {
+            snprintf(prefix, sizeof(prefix), "/riot/test/fib/%u/", i);
+            if (fib_add(prefix, i) < 0) {
+                printf("# fib refused prefix %u\n", i);
+                return;
+            }
+        }
+        add = bench_elapsed(start);
+
+        for (unsigned i = 0; i < FIB_BENCH_LOCAL_NAMES; i++) {
+            snprintf(hit_name[i], FIB_BENCH_NAME_LEN, "/riot/test/fib/%" PRIu32 "/data",
+                     genrand_uint32() % size);
+            snprintf(miss_name[i], FIB_BENCH_NAME_LEN, "/riot/test/bif/%u/data", i);
+        }
+
+        vtimer_now(&start);
+        for (unsigned i = 0; i < FIB_BENCH_LOCAL_LOOKUPS; i++) {
+            face = fib_lookup(hit_name[i % FIB_BENCH_LOCAL_NAMES]);
+        }
+        hit = bench_elapsed(start);
+
+        vtimer_now(&start);
+        for (unsigned i = 0; i < FIB_BENCH_LOCAL_LOOKUPS; i++) {
+            face = fib_lookup(miss_name[i % FIB_BENCH_LOCAL_NAMES]);
+        }
+        miss = bench_elapsed(start);
+        (void) face;
+
+        fib_stats(&stats);
+        printf("csv,fib,local,%s,%u,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%u,%u\n",
+               fib_backend(), size, add * 1000 / size,
+               hit * 1000 / FIB_BENCH_LOCAL_LOOKUPS, miss * 1000 / FIB_BENCH_LOCAL_LOOKUPS,
+               stats.bytes, stats.bytes / stats.entries);
+    }
+}
+
+void fib_bench(kernel_pid_t relay_pid, int argc, char **argv)
+{
+    relay = relay_pid;
+    bench_drain();
+
+    if (argc < 2 || strcmp(argv[1], "relay") == 0) {
+        bench_relay();
+    }
+    if (argc < 2 || strcmp(argv[1], "local") == 0) {
+        bench_local();
+    }
+}
+
+#endif /* RIOT_CCN_TESTS */
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief FIB benchmark for the ccn-lite relay and fib.h
+ *
+ * @}
+ */
+
+#ifndef FIBBENCH_H
+#define FIBBENCH_H
+
+#include "kernel.h"
+
+/**
+ * @brief register prefixes with the relay and the local FIB and print
+ *        the cost of registrations and lookups as CSV
+ *
+ * usage: fibtest [relay|local]
+ */
+void fib_bench(kernel_pid_t relay_pid, int argc, char **argv);
+
+#endif /* FIBBENCH_H */
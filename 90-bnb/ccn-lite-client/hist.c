@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Latency histograms for the CCN benchmarks
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "hist.h"
+
+void hist_reset(hist_t *h)
+{
+    memset(h, 0, sizeof(*h));
+    h->min = UINT32_MAX;
+}
+
+void hist_add(hist_t *h, uint32_t us)
+{
+    unsigned i = 0;
+
+    while (us >> i && i < HIST_BUCKETS - 1) {
+        i++;
+    }
+    h->bucket[i]++;
+    h->count++;
+    h->sum += us;
+    if (us < h->min) {
+        h->min = us;
+    }
+    if (us > h->max) {
+        h->max = us;
+    }
+}
+
+uint32_t hist_percentile(const hist_t *h, unsigned pct)
+{
+    uint32_t rank = ((uint64_t) h->count * pct + 99) / 100;
+    uint32_t seen = 0;
+
+    for (unsigned i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->bucket[i];
+        if (seen >= rank && seen) {
+            uint32_t bound = (1UL << i) - 1;
+            return (i == HIST_BUCKETS - 1 || bound > h->max) ? h->max : bound;
+        }
+    }
+    return h->max;
+}
+
+void hist_print_csv(const hist_t *h)
+{
+    if (h->count == 0) {
+        printf("0,0,0,0,0,0");
+    }
+    else {
+        printf("%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32,
+               h->count, h->min, (uint32_t)(h->sum / h->count),
+               hist_percentile(h, 50), hist_percentile(h, 99), h->max);
+    }
+    for (unsigned i = 0; i < HIST_BUCKETS; i++) {
+        printf(",%" PRIu32, h->bucket[i]);
+    }
+    puts("");
+}
+
+void hist_print_csv_header(void)
+{
+    printf("count,min_us,mean_us,p50_us,p99_us,max_us");
+    for (unsigned i = 0; i < HIST_BUCKETS; i++) {
+        printf(",lt%luus", 1UL << i);
+    }
+    puts("");
+}
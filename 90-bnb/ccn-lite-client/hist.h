@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Latency histograms for the CCN benchmarks
+ *
+ * Bucket i counts samples of at least 2^(i-1) and less than 2^i us, bucket
+ * 0 those below 1 us.
+ *
+ * @}
+ */
+
+#ifndef HIST_H
+#define HIST_H
+
+#include <stdint.h>
+
+#define HIST_BUCKETS (20)
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t bucket[HIST_BUCKETS];
+} hist_t;
+
+void hist_reset(hist_t *h);
+
+/**
+ * @brief add a sample in us
+ */
+void hist_add(hist_t *h, uint32_t us);
+
+/**
+ * @brief upper bound of the bucket holding the given percentile in us
+ */
+uint32_t hist_percentile(const hist_t *h, unsigned pct);
+
+/**
+ * @brief print count,min,mean,p50,p99,max and the buckets as CSV fields
+ */
+void hist_print_csv(const hist_t *h);
+
+/**
+ * @brief print the header matching hist_print_csv()
+ */
+void hist_print_csv_header(void);
+
+#endif /* HIST_H */
@@ -39,8 +39,14 @@
 #include "ccn_lite/ccnl-riot.h"
 #include "ccn_lite/util/ccnl-riot-client.h"
 
+#include "pitbench.h"
+#include "fibbench.h"
+
 #define RIOT_CCN_APPSERVER (1)
+/* set in the Makefile, as fib.c and fibbench.c depend on it, too */
+#ifndef RIOT_CCN_TESTS
 #define RIOT_CCN_TESTS (0)
+#endif
 
 char relay_stack[KERNEL_CONF_STACKSIZE_MAIN];
 
@@ -132,7 +138,7 @@ static void riot_ccn_register_prefix(int argc, char **argv)
 
 static void riot_ccn_relay_config(int argc, char **argv)
 {
-    if (_relay_pid == KERNEL_PID_UNDEF) {
+    if (relay_pid == KERNEL_PID_UNDEF) {
         puts("ccnl stack not running");
         return;
     }
@@ -145,7 +151,7 @@ static void riot_ccn_relay_config(int argc, char **argv)
     msg_t m;
     m.content.value = atoi(argv[1]);
     m.type = CCNL_RIOT_CONFIG_CACHE;
-    msg_send(&m, _relay_pid);
+    msg_send(&m, relay_pid);
 }
 
 static void riot_ccn_transceiver_start(kernel_pid_t _relay_pid)
@@ -211,80 +217,22 @@ static void riot_ccn_relay_stop(int argc, char **argv)
 #if RIOT_CCN_TESTS
 static void riot_ccn_pit_test(int argc, char **argv)
 {
-    (void) argc; /* the function takes no arguments */
-    (void) argv;
-
-    char name[] = "/riot/test";
-
-    char *prefix[CCNL_MAX_NAME_COMP];
-    char *cp = strtok(name, "/");
-    int i = 0;
-
-    while (i < (CCNL_MAX_NAME_COMP - 1) && cp) {
-        prefix[i++] = cp;
-        cp = strtok(NULL, "/");
-    }
-
-    //prefix[i] = 0; //segment to request
-    prefix[i + 1] = 0;
-
-    msg_t m;
-    riot_ccnl_msg_t rmsg;
-    char segment_string[16]; //max=999\0
-    timex_t now;
-
-    int segment;
-
-    for (segment = 0; segment < 200; segment++) {
-        memset(segment_string, 0, 16);
-        snprintf(segment_string, 16, "%d", segment);
-        prefix[i] = segment_string;
-        unsigned int interest_nonce = genrand_uint32();
-        int interest_len = mkInterest(prefix, &interest_nonce, (unsigned char *) small_buf);
-
-        rmsg.payload = &small_buf;
-        rmsg.size = interest_len;
-        m.content.ptr = (char *) &rmsg;
-        m.type = CCNL_RIOT_MSG;
-
-        msg_send(&m, relay_pid);
-
-        if ((segment % 50) == 0) {
-            vtimer_now(&now);
-            printf("done: %d - %ld.%ld\n", segment, now.tv_sec, now.tv_usec);
-        }
+    if (relay_pid == KERNEL_PID_UNDEF) {
+        puts("ccnl stack not running");
+        return;
     }
 
-    printf("done: tried to send %d interests\n", segment);
+    pit_bench(relay_pid, argc, argv);
 }
 
 static void riot_ccn_fib_test(int argc, char **argv)
 {
-    (void) argc; /* the function takes no arguments */
-    (void) argv;
-
-    char type[] = "newTRANSface";
-    char faceid[] = "42";
-
-    riot_new_face(relay_pid, type, faceid, big_buf);
-
-    timex_t now;
-    int i = -1;
-
-    do {
-        i++;
-        snprintf(small_buf, sizeof(small_buf), "/riot/test/fib/%d/", i);
-        riot_register_prefix(relay_pid, small_buf, faceid, big_buf);
-
-        if (i % 50 == 0) {
-            vtimer_now(&now);
-            printf("done: %d - %ld.%ld\n", i, now.tv_sec, now.tv_usec);
-        }
+    if (relay_pid == KERNEL_PID_UNDEF) {
+        puts("ccnl stack not running");
+        return;
     }
-    while (0 == strcmp((const char *) big_buf, "prefixreg cmd worked"));
 
-    DEBUG("%d: '%s'\n", i, big_buf);
-    printf("done: %d\n", i - 1);
+    fib_bench(relay_pid, argc, argv);
 }
 #endif
 
@@ -321,8 +269,8 @@ static const shell_command_t sc[] = {
     { "appserver", "starts an application server to reply to interests", riot_ccn_appserver },
 #endif
 #if RIOT_CCN_TESTS
-    { "pittest", "starts a test for the size and speed of pit operations", riot_ccn_pit_test },
-    { "fibtest", "starts a test for the size and speed of fib operations", riot_ccn_fib_test },
+    { "pittest", "benchmarks pit operations, prints csv: pittest [expiry]", riot_ccn_pit_test },
+    { "fibtest", "benchmarks fib operations, prints csv: fibtest [relay|local]", riot_ccn_fib_test },
 #endif
     { NULL, NULL, NULL }
 };
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief PIT benchmark for the ccn-lite relay
+ *
+ * The relay runs at a higher priority than the shell, so sending it a
+ * message returns only once the relay is done with it. Timing msg_send()
+ * with vtimer_now() therefore gives the cost of
+ *
+ *  - insert:   an interest for a name that is not pending yet
+ *  - miss:     content nobody asked for, the PIT is searched in vain
+ *  - hit:      content for a pending interest, which is then removed
+ *
+ * for each combination of outstanding interests, name depth and length of
+ * the name components. Every configuration uses fresh names, so nothing is
+ * answered from the content store, and the hits leave the PIT empty again.
+ *
+ * Expiry happens in the relay's ageing timer and cannot be timed from the
+ * outside. With SCHEDSTATISTICS, `pittest expiry` reports the run time the
+ * relay thread spent while the interests timed out instead. This includes
+ * the ageing of faces and the content store, so compare it against a run
+ * with no interests outstanding.
+ *
+ * Output is CSV, one line per operation and configuration:
+ *
+ *      csv,pit,<op>,<outstanding>,<depth>,<comp len>,<histogram, see hist.h>
+ *      csv,pit,expire,<outstanding>,<depth>,<comp len>,<nacks>,<relay us>,<ns per entry>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "msg.h"
+#include "vtimer.h"
+#include "random.h"
+#ifdef SCHEDSTATISTICS
+#include "sched.h"
+#include "hwtimer.h"
+#endif
+
+#include "ccn_lite/ccnl-riot.h"
+
+#include "hist.h"
+#include "pitbench.h"
+
+#define PIT_BENCH_COMP_MAX  (16)
+#define PIT_BENCH_PKT_SIZE  (256)
+
+/* the relay gives up on an interest after a few retransmissions */
+#ifndef PIT_BENCH_EXPIRY_WAIT
+#define PIT_BENCH_EXPIRY_WAIT   (15 * 1000 * 1000U)
+#endif
+#define PIT_BENCH_POLL      (100 * 1000U)
+
+static const unsigned sweep_n[] = { 10, 50, 100, 200, 400 };
+static const unsigned sweep_depth[] = { 2, 4, 8 };
+static const unsigned sweep_len[] = { 4, 8, 16 };
+
+#define SWEEP(a) (sizeof(a) / sizeof(a[0]))
+
+#define EXPIRY_DEPTH        (4)
+#define EXPIRY_LEN          (8)
+
+static kernel_pid_t relay;
+static unsigned run_id;
+
+static char comp[CCNL_MAX_NAME_COMP][PIT_BENCH_COMP_MAX + 1];
+static char *name[CCNL_MAX_NAME_COMP];
+static unsigned char pkt[PIT_BENCH_PKT_SIZE];
+static riot_ccnl_msg_t rmsg;
+
+static unsigned replies;
+static unsigned nacks;
+
+static hist_t h_insert;
+static hist_t h_miss;
+static hist_t h_hit;
+
+/* /r<run>/bbbb/cccc/.../<idx>, every component <len> characters long, the
+ * first one longer once the run number needs more digits, so that the
+ * names of different runs never collide */
+static void bench_prefix(unsigned depth, unsigned len)
+{
+    snprintf(comp[0], sizeof(comp[0]), "r%0*u", len - 1, run_id);
+    name[0] = comp[0];
+    for (unsigned i = 1; i < depth - 1; i++) {
+        memset(comp[i], 'a' + i, len);
+        comp[i][len] = '\0';
+        name[i] = comp[i];
+    }
+    name[depth - 1] = comp[depth - 1];
+    name[depth] = NULL;
+}
+
+static void bench_name(unsigned depth, unsigned len, unsigned idx)
+{
+    snprintf(comp[depth - 1], len + 1, "%0*u", len, idx);
+}
+
+/* replies and NACKs end up in the shell's queue, which must not fill up */
+static void bench_drain(void)
+{
+    msg_t m;
+
+    while (msg_try_receive(&m) == 1) {
+        if (m.type == CCNL_RIOT_MSG) {
+            ccnl_free(m.content.ptr);
+            replies++;
+        }
+        else if (m.type == CCNL_RIOT_NACK) {
+            nacks++;
+        }
+    }
+}
+
+static uint32_t bench_send(int len)
+{
+    msg_t m;
+    timex_t start, end;
+
+    rmsg.payload = pkt;
+    rmsg.size = len;
+    m.type = CCNL_RIOT_MSG;
+    m.content.ptr = (char *) &rmsg;
+
+    vtimer_now(&start);
+    msg_send(&m, relay);
+    vtimer_now(&end);
+
+    bench_drain();
+    return timex_uint64(timex_sub(end, start));
+}
+
+static void bench_interests(unsigned n, unsigned depth, unsigned len, hist_t *h)
+{
+    for (unsigned i = 0; i < n; i++) {
+        unsigned int nonce = genrand_uint32();
+        bench_name(depth, len, i);
+        int size = mkInterest(name, &nonce, pkt);
+        uint32_t us = bench_send(size);
+        if (h) {
+            hist_add(h, us);
+        }
+    }
+}
+
+static void bench_contents(unsigned first, unsigned n, unsigned depth, unsigned len, hist_t *h)
+{
+    char data[] = "x";
+
+    for (unsigned i = first; i < first + n; i++) {
+        bench_name(depth, len, i);
+        int size = mkContent(name, data, sizeof(data), pkt);
+        hist_add(h, bench_send(size));
+    }
+}
+
+static void bench_print(const char *op, unsigned n, unsigned depth, unsigned len, hist_t *h)
+{
+    printf("csv,pit,%s,%u,%u,%u,", op, n, depth, len);
+    hist_print_csv(h);
+}
+
+static void bench_run(unsigned n, unsigned depth, unsigned len)
+{
+    ++run_id;
+    bench_prefix(depth, len);
+    hist_reset(&h_insert);
+    hist_reset(&h_miss);
+    hist_reset(&h_hit);
+    replies = 0;
+
+    bench_interests(n, depth, len, &h_insert);
+    bench_contents(n, n, depth, len, &h_miss);
+    bench_contents(0, n, depth, len, &h_hit);
+
+    bench_print("insert", n, depth, len, &h_insert);
+    bench_print("miss", n, depth, len, &h_miss);
+    bench_print("hit", n, depth, len, &h_hit);
+    if (replies != n) {
+        printf("# %u of %u interests were not satisfied\n", n - replies, n);
+    }
+}
+
+#ifdef SCHEDSTATISTICS
+static uint64_t relay_runtime(void)
+{
+    return HWTIMER_TICKS_TO_US(pidlist[relay].runtime_ticks);
+}
+
+static void bench_expiry(unsigned n)
+{
+    ++run_id;
+    bench_prefix(EXPIRY_DEPTH, EXPIRY_LEN);
+    nacks = 0;
+
+    bench_interests(n, EXPIRY_DEPTH, EXPIRY_LEN, NULL);
+    uint64_t before = relay_runtime();
+    for (uint32_t t = 0; t < PIT_BENCH_EXPIRY_WAIT; t += PIT_BENCH_POLL) {
+        vtimer_usleep(PIT_BENCH_POLL);
+        bench_drain();
+    }
+    uint64_t spent = relay_runtime() - before;
+
+    printf("csv,pit,expire,%u,%u,%u,%u,%" PRIu32 ",%" PRIu32 "\n", n, EXPIRY_DEPTH,
+           EXPIRY_LEN, nacks, (uint32_t) spent, n ? (uint32_t)(spent * 1000 / n) : 0);
+}
+#endif
+
+void pit_bench(kernel_pid_t relay_pid, int argc, char **argv)
+{
+    relay = relay_pid;
+    bench_drain();
+
+    if (argc > 1 && strcmp(argv[1], "expiry") == 0) {
+#ifdef SCHEDSTATISTICS
+        puts("csv,pit,expire,outstanding,depth,comp_len,nacks,relay_us,ns_per_entry");
+        bench_expiry(0);
+        for (unsigned i = 0; i < SWEEP(sweep_n); i++) {
+            bench_expiry(sweep_n[i]);
+        }
+#else
+        puts("expiry needs SCHEDSTATISTICS, see the Makefile");
+#endif
+        return;
+    }
+
+    printf("csv,pit,op,outstanding,depth,comp_len,");
+    hist_print_csv_header();
+    for (unsigned i = 0; i < SWEEP(sweep_n); i++) {
+        for (unsigned j = 0; j < SWEEP(sweep_depth); j++) {
+            for (unsigned k = 0; k < SWEEP(sweep_len); k++) {
+                bench_run(sweep_n[i], sweep_depth[j], sweep_len[k]);
+            }
+        }
+    }
+}
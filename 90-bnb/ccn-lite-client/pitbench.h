@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief PIT benchmark for the ccn-lite relay
+ *
+ * @}
+ */
+
+#ifndef PITBENCH_H
+#define PITBENCH_H
+
+#include "kernel.h"
+
+/**
+ * @brief sweep the PIT size, name depth and component length and print
+ *        the cost of PIT operations as CSV
+ *
+ * usage: pittest [expiry]
+ */
+void pit_bench(kernel_pid_t relay_pid, int argc, char **argv);
+
+#endif /* PITBENCH_H */
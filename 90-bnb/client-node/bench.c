@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup     cebit_sensor
+ * @{
+ *
+ * @file        bench.c
+ * @brief       CeBIT 2014 demo application - detection benchmark
+ *
+ * Replays a recorded trace (see trace.h) through a private instance of the
+ * detection pipeline and reports detection latency, false positives and
+ * false negatives against the ground truth of the trace, and the CPU time
+ * spent per sample. CPU time is the run time the scheduler accounts to the
+ * shell thread, so it needs SCHEDSTATISTICS, and time other threads take
+ * in between is not counted. The last line of the output is CSV, so results
+ * can be compared from build to build:
+ *
+ *      csv,<trace>,<samples>,<episodes>,<detected>,<fp>,<fn>,
+ *          <avg latency [samples/100]>,<max latency [samples]>,<ns/sample>
+ *
+ * @}
+ */
+
+#ifdef BOARD_NATIVE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "thread.h"
+#ifdef SCHEDSTATISTICS
+#include "sched.h"
+#include "hwtimer.h"
+#endif
+
+#include "bench.h"
+#include "detect.h"
+#include "trace.h"
+
+/* nominal sampling period if the trace does not specify one */
+#define BENCH_PERIOD        (50000U)
+/* samples are loaded in blocks, so only detection is timed */
+#define BENCH_BLOCK         (256)
+
+typedef struct {
+    uint32_t samples;
+    unsigned episodes;
+    unsigned detected;
+    unsigned false_pos;
+    unsigned false_neg;
+    uint32_t lat_sum;
+    uint32_t lat_max;
+    uint64_t cpu_us;
+} bench_result_t;
+
+static trace_sample_t block[BENCH_BLOCK];
+static int8_t reported[BENCH_BLOCK];
+
+#ifdef SCHEDSTATISTICS
+/* run time of the calling thread, the scheduler brings it up to date when
+ * the thread yields */
+static uint64_t bench_cpu_us(void)
+{
+    thread_yield();
+    return HWTIMER_TICKS_TO_US(pidlist[thread_getpid()].runtime_ticks);
+}
+
+
+static void bench_run(trace_t *trace, bench_result_t *res)
+{
+    detect_t d;
+    int truth = TRACE_NO_LABEL;
+    int last_axis = TRACE_NO_LABEL;
+    int found = 0;
+    uint32_t start = 0;
+    int n;
+
+    detect_reset(&d);
+
+    do {
+        for (n = 0; n < BENCH_BLOCK && trace_read(trace, &block[n]); n++);
+
+        uint64_t t0 = bench_cpu_us();
+        for (int i = 0; i < n; i++) {
+            reported[i] = detect_sample(&d, block[i].acc);
+        }
+        res->cpu_us += bench_cpu_us() - t0;
+
+        for (int i = 0; i < n; i++, res->samples++) {
+            /* a new episode starts whenever the board settles on an
+             * orientation other than the one it had before */
+            if (block[i].label != truth) {
+                truth = block[i].label;
+                if (truth != TRACE_NO_LABEL && truth != last_axis) {
+                    if (last_axis != TRACE_NO_LABEL && !found) {
+                        res->false_neg++;
+                    }
+                    last_axis = truth;
+                    start = res->samples;
+                    found = 0;
+                    res->episodes++;
+                }
+            }
+
+            if (reported[i] == DETECT_NONE) {
+                continue;
+            }
+            if (reported[i] == truth && !found) {
+                uint32_t latency = res->samples - start;
+                found = 1;
+                res->detected++;
+                res->lat_sum += latency;
+                if (latency > res->lat_max) {
+                    res->lat_max = latency;
+                }
+            }
+            else {
+                res->false_pos++;
+            }
+        }
+    } while (n == BENCH_BLOCK);
+
+    if (last_axis != TRACE_NO_LABEL && !found) {
+        res->false_neg++;
+    }
+}
+
+void bench_detect(int argc, char **argv)
+{
+    trace_t trace;
+    bench_result_t res = { 0 };
+    unsigned runs = 1;
+
+    if (argc < 2) {
+        printf("usage: %s <trace> [<runs>]\n", argv[0]);
+        return;
+    }
+    if (argc > 2) {
+        int n = atoi(argv[2]);
+        if (n <= 0) {
+            puts("the number of runs has to be at least 1");
+            return;
+        }
+        runs = n;
+    }
+    if (trace_open(&trace, argv[1]) < 0) {
+        printf("cannot open %s\n", argv[1]);
+        return;
+    }
+
+    /* detection results of the first run are reported, later runs only
+     * add to the CPU time */
+    bench_run(&trace, &res);
+    for (unsigned r = 1; r < runs; r++) {
+        bench_result_t more = { 0 };
+        trace_rewind(&trace);
+        bench_run(&trace, &more);
+        res.cpu_us += more.cpu_us;
+    }
+
+    uint32_t period = trace.period ? trace.period : BENCH_PERIOD;
+    trace_close(&trace);
+
+    if (res.samples == 0) {
+        puts("trace is empty");
+        return;
+    }
+
+    uint32_t lat_avg = res.detected ? (res.lat_sum * 100) / res.detected : 0;
+    uint32_t ns = (uint32_t)((res.cpu_us * 1000) / ((uint64_t) res.samples * runs));
+
+    printf("samples: %" PRIu32 " (period %" PRIu32 " us)\n", res.samples, period);
+    printf("episodes: %u, detected: %u, false positives: %u, false negatives: %u\n",
+           res.episodes, res.detected, res.false_pos, res.false_neg);
+    printf("latency: avg %" PRIu32 ".%02" PRIu32 " samples (%" PRIu32 " ms), "
+           "max %" PRIu32 " samples (%" PRIu32 " ms)\n",
+           lat_avg / 100, lat_avg % 100, (lat_avg * (period / 1000)) / 100,
+           res.lat_max, res.lat_max * (period / 1000));
+    printf("cpu: %" PRIu32 " ns/sample\n", ns);
+    printf("csv,%s,%" PRIu32 ",%u,%u,%u,%u,%" PRIu32 ",%" PRIu32 ",%" PRIu32 "\n",
+           argv[1], res.samples, res.episodes, res.detected, res.false_pos,
+           res.false_neg, lat_avg, res.lat_max, ns);
+}
+#else
+
+void bench_detect(int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+
+    puts("bench needs SCHEDSTATISTICS, see the Makefile");
+}
+#endif /* SCHEDSTATISTICS */
+
+#endif /* BOARD_NATIVE */
@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup     cebit_sensor
+ * @{
+ *
+ * @file        bench.h
+ * @brief       CeBIT 2014 demo application - detection benchmark
+ *
+ * @}
+ */
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+/**
+ * @brief       Shell command replaying a trace through the detection
+ *              pipeline, only available on the native board.
+ */
+void bench_detect(int argc, char **argv);
+
+#endif /* __BENCH_H */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup     cebit_sensor
+ * @{
+ *
+ * @file        detect.c
+ * @brief       CeBIT 2014 demo application - integer-only tilt detection
+ *
+ * @}
+ */
+
+#include <stdint.h>
+
+#include "detect.h"
+
+/* the same bounds as (int) sqrt(norm_sq) > MIN and < MAX */
+#define NORM_MIN_SQ         ((int32_t) (DETECT_NORM_MIN + 1) * (DETECT_NORM_MIN + 1))
+#define NORM_MAX_SQ         ((int32_t) DETECT_NORM_MAX * DETECT_NORM_MAX)
+#define AXIS_RELEASE        (AXIS_THRESHOLD - DETECT_HYSTERESIS)
+
+
+void detect_reset(detect_t *d)
+{
+#if DETECT_MAVG_SHIFT > 0
+    for (int i = 0; i < 3; i++) {
+        d->mavg_sum[i] = 0;
+    }
+    d->mavg_pos = 0;
+    d->mavg_fill = 0;
+#endif
+    for (int i = 0; i < 3; i++) {
+        d->axis_active[i] = 0;
+    }
+    d->state = -1;
+    d->rep_count = 0;
+}
+
+int detect_rep_count(const detect_t *d)
+{
+    return d->rep_count;
+}
+
+#if DETECT_MAVG_SHIFT > 0
+/* returns 0 until the window has been filled once */
+static int stage_mavg(detect_t *d, const int16_t *in, int16_t *out)
+{
+    for (int i = 0; i < 3; i++) {
+        if (d->mavg_fill == DETECT_MAVG_LEN) {
+            d->mavg_sum[i] -= d->mavg_buf[d->mavg_pos][i];
+        }
+        d->mavg_buf[d->mavg_pos][i] = in[i];
+        d->mavg_sum[i] += in[i];
+        out[i] = (int16_t)(d->mavg_sum[i] >> DETECT_MAVG_SHIFT);
+    }
+    d->mavg_pos = (d->mavg_pos + 1) & (DETECT_MAVG_LEN - 1);
+    if (d->mavg_fill < DETECT_MAVG_LEN) {
+        ++d->mavg_fill;
+    }
+    return d->mavg_fill == DETECT_MAVG_LEN;
+}
+#endif
+
+static int stage_norm(const int16_t *v)
+{
+    int32_t norm_sq = 0;
+
+    for (int i = 0; i < 3; i++) {
+        norm_sq += (int32_t) v[i] * v[i];
+    }
+    return (norm_sq >= NORM_MIN_SQ && norm_sq < NORM_MAX_SQ);
+}
+
+/* returns 1 if the axis is (still) beyond the threshold, without hysteresis
+ * an axis at exactly the threshold is released */
+static int stage_threshold(detect_t *d, int axis, int16_t value)
+{
+    int16_t mag = (value < 0) ? -value : value;
+
+    if (mag > AXIS_THRESHOLD) {
+        d->axis_active[axis] = 1;
+    }
+    else if (mag <= AXIS_RELEASE) {
+        d->axis_active[axis] = 0;
+    }
+    return d->axis_active[axis];
+}
+
+static void stage_debounce(detect_t *d, int axis)
+{
+    if (d->state == axis) {
+        if (d->rep_count < DETECT_REP_LIMIT) {
+            ++d->rep_count;
+        }
+    }
+    else {
+        d->state = axis;
+        d->rep_count = 0;
+    }
+}
+
+int detect_sample(detect_t *d, const int16_t *acc)
+{
+    const int16_t *v = acc;
+
+#if DETECT_MAVG_SHIFT > 0
+    int16_t avg[3];
+    if (!stage_mavg(d, acc, avg)) {
+        return DETECT_NONE;
+    }
+    v = avg;
+#endif
+
+    if (stage_norm(v)) {
+        for (int i = 0; i < 3; i++) {
+            if (stage_threshold(d, i, v[i])) {
+                stage_debounce(d, i);
+            }
+        }
+    }
+
+    if (d->rep_count == DETECT_REP_LIMIT) {
+        d->rep_count = DETECT_REP_LIMIT + 1;
+        return d->state;
+    }
+    return DETECT_NONE;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup     cebit_sensor
+ * @{
+ *
+ * @file        detect.h
+ * @brief       CeBIT 2014 demo application - integer-only tilt detection
+ *
+ * The pipeline is made of the following stages, each of them can be
+ * configured (or disabled) at compile time by overriding the macros below
+ * through CFLAGS:
+ *
+ * 1. moving average over 2^DETECT_MAVG_SHIFT samples per axis
+ * 2. norm gate, comparing the squared norm against squared bounds
+ *    (int) |acc| > DETECT_NORM_MIN and < DETECT_NORM_MAX
+ * 3. axis threshold: an axis above AXIS_THRESHOLD is active until it
+ *    drops to AXIS_THRESHOLD - DETECT_HYSTERESIS
+ * 4. debounce, an axis has to be seen DETECT_REP_LIMIT times in a row
+ *
+ * @}
+ */
+
+#ifndef __DETECT_H
+#define __DETECT_H
+
+#include <stdint.h>
+
+/** moving average window as a power of two, 0 disables the stage */
+#ifndef DETECT_MAVG_SHIFT
+#define DETECT_MAVG_SHIFT   (0)
+#endif
+
+/** accepted range of the acceleration norm, in raw SMB380 counts */
+#ifndef DETECT_NORM_MIN
+#define DETECT_NORM_MIN     (235)
+#endif
+#ifndef DETECT_NORM_MAX
+#define DETECT_NORM_MAX     (275)
+#endif
+
+/** an axis beyond this value points (roughly) towards the earth */
+#ifndef AXIS_THRESHOLD
+#define AXIS_THRESHOLD      (230)
+#endif
+
+/** an axis has to drop this much below AXIS_THRESHOLD to be released */
+#ifndef DETECT_HYSTERESIS
+#define DETECT_HYSTERESIS   (0)
+#endif
+
+/** number of repetitions before an orientation is reported */
+#ifndef DETECT_REP_LIMIT
+#define DETECT_REP_LIMIT    (3)
+#endif
+
+/** returned by detect_sample() if nothing has to be reported */
+#define DETECT_NONE         (-1)
+
+#if DETECT_MAVG_SHIFT > 0
+#define DETECT_MAVG_LEN     (1 << DETECT_MAVG_SHIFT)
+#endif
+
+/**
+ * @brief       State of one detection pipeline
+ */
+typedef struct {
+#if DETECT_MAVG_SHIFT > 0
+    int16_t mavg_buf[DETECT_MAVG_LEN][3];
+    int32_t mavg_sum[3];
+    unsigned mavg_pos;
+    unsigned mavg_fill;
+#endif
+    int axis_active[3];
+    int state;
+    int rep_count;
+} detect_t;
+
+/**
+ * @brief       Reset all filter stages.
+ */
+void detect_reset(detect_t *d);
+
+/**
+ * @brief       Feed one raw sample into the detection pipeline.
+ *
+ * @param[in] d     pipeline to use
+ * @param[in] acc   X, Y and Z acceleration in raw SMB380 counts
+ *
+ * @return      the axis that points downwards once it has been confirmed,
+ *              DETECT_NONE otherwise
+ */
+int detect_sample(detect_t *d, const int16_t *acc);
+
+/**
+ * @brief       Number of times the current axis has been seen so far,
+ *              DETECT_REP_LIMIT + 1 once it has been reported.
+ */
+int detect_rep_count(const detect_t *d);
+
+#endif /* __DETECT_H */
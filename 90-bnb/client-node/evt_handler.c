@@ -19,14 +19,71 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+#include <stdint.h>
 #include "vtimer.h"
+#include "thread.h"
+#include "kernel.h"
+#include "irq.h"
 
 #include "board.h"
 #include "evt_handler.h"
 #include "../events.h"
+#include "../evt_codec.h"
 
+/* number of events that can be pending, has to be a power of two */
+#define EVT_QUEUE_SIZE      (8U)
+#define EVT_PRIO            (PRIORITY_MAIN - 1)
+#define EVT_STACKSIZE       (KERNEL_CONF_STACKSIZE_MAIN)
+
+/* minimum time between two requests for the same event type, events in
+ * between are merged into a single request sent once the interval is over */
+#define EVT_INTERVAL_OK     (10 * 1000 * 1000U)
+#define EVT_INTERVAL_WARN   (2 * 1000 * 1000U)
+#define EVT_INTERVAL_ALARM  (1 * 1000 * 1000U)
+
+/* events are addressed to the root, which forwards them to the actuators */
+#define EVT_DST             (1)
+
+#define EVT_NAME_LEN        (64)
+/* largest merged count a request carries, the data field is a char */
+#define EVT_MERGED_MAX      (127U)
+
+static char evt_stack[EVT_STACKSIZE];
+static int evt_pid;
+
+/* single producer (sense thread), single consumer (dispatcher) */
+static evt_t evt_queue[EVT_QUEUE_SIZE];
+static volatile unsigned evt_head = 0;
+static volatile unsigned evt_tail = 0;
+static unsigned evt_peak = 0;
+static unsigned evt_posted = 0;
+static unsigned evt_dropped = 0;
+
+/* rate limiting state per event type */
+typedef struct {
+    evt_t event;
+    const char *name;
+    uint32_t interval;
+    timex_t last;
+    int sent;
+    unsigned suppressed;
+} evt_limit_t;
+
+static evt_limit_t limits[] = {
+    { CONFIRM, "ok", EVT_INTERVAL_OK, { 0, 0 }, 0, 0 },
+    { WARN, "warn", EVT_INTERVAL_WARN, { 0, 0 }, 0, 0 },
+    { ALARM, "alarm", EVT_INTERVAL_ALARM, { 0, 0 }, 0, 0 },
+};
+
+#define EVT_LIMITS          (sizeof(limits) / sizeof(limits[0]))
+
+static vtimer_t flush_timer;
+static unsigned evt_requests = 0;
+static unsigned evt_merged = 0;
 
 void send_event(evt_t event);
+static uint32_t flush_events(void);
 
 #ifndef LED_GREEN_ON
 #define LED_GREEN_ON puts("ON")
@@ -35,45 +92,231 @@ void send_event(evt_t event);
 #define LED_GREEN_OFF puts("OFF")
 #endif
 
+/* hand an event over to the dispatcher, never blocks */
+static void post_event(evt_t event)
+{
+    unsigned depth = evt_head - evt_tail;
+
+    if (depth >= EVT_QUEUE_SIZE) {
+        ++evt_dropped;
+        return;
+    }
+    evt_queue[evt_head & (EVT_QUEUE_SIZE - 1)] = event;
+    ++evt_head;
+    ++evt_posted;
+    if (depth + 1 > evt_peak) {
+        evt_peak = depth + 1;
+    }
+    thread_wakeup(evt_pid);
+}
+
+static void *evt_dispatcher(void *unused)
+{
+    (void) unused;
+
+    for (;;) {
+        uint32_t next = flush_events();
+
+        /* wake up again when the next merged request is due */
+        vtimer_remove(&flush_timer);
+        if (next) {
+            vtimer_set_wakeup(&flush_timer, timex_set(0, next), evt_pid);
+        }
+
+        /* make sure no event slips in between the check and going to sleep */
+        unsigned irq_state = disableIRQ();
+        if (evt_head == evt_tail) {
+            thread_sleep();
+        }
+        restoreIRQ(irq_state);
+
+        while (evt_head != evt_tail) {
+            evt_t event = evt_queue[evt_tail & (EVT_QUEUE_SIZE - 1)];
+            ++evt_tail;
+            send_event(event);
+        }
+    }
+    return NULL;
+}
+
+void evt_handler_init(void)
+{
+    evt_pid = thread_create(evt_stack, sizeof(evt_stack), EVT_PRIO,
+                            CREATE_STACKTEST, evt_dispatcher, NULL, "evt");
+    puts("Event dispatcher created.");
+}
+
+void evt_handler_stats(evt_handler_stats_t *stats)
+{
+    stats->depth = evt_head - evt_tail;
+    stats->peak = evt_peak;
+    stats->posted = evt_posted;
+    stats->dropped = evt_dropped;
+    stats->requests = evt_requests;
+    stats->merged = evt_merged;
+}
+
+int evt_handler_set_interval(const char *name, uint32_t ms)
+{
+    /* the interval is kept in us */
+    if (ms > EVT_INTERVAL_MAX_MS) {
+        return -1;
+    }
+    for (unsigned i = 0; i < EVT_LIMITS; i++) {
+        if (strcmp(limits[i].name, name) == 0) {
+            limits[i].interval = ms * 1000;
+            return 0;
+        }
+    }
+    return -1;
+}
+
 void evt_handler_ok(void)
 {
     puts("EVENT: all good");
     // send status ok to actuator nodes
-    send_event(CONFIRM);
+    post_event(CONFIRM);
 }
 
 void evt_handler_warn(void)
 {
     puts("EVENT: warning");
     // send status warning to actuator nodes
-    send_event(WARN);
+    post_event(WARN);
 }
 
 void evt_handler_alarm(void)
 {
     puts("EVENT: alarm");
     // send alarm event to actuator nodes
-    send_event(ALARM);
+    post_event(ALARM);
 }
 
-extern void interest(const char *argv);
+extern int interest(const char *name);
+
+/* time since the last request of this type, saturated to UINT32_MAX us */
+static uint32_t time_since(evt_limit_t *l)
+{
+    timex_t now;
+
+    if (!l->sent) {
+        return UINT32_MAX;
+    }
+    vtimer_now(&now);
+    uint64_t delta = timex_uint64(timex_sub(now, l->last));
+    return (delta > UINT32_MAX) ? UINT32_MAX : (uint32_t) delta;
+}
+
+/*
+ * Name of the request for a set of events: /riot/appserver/test/<frame>,
+ * with the events encoded as in evt_codec.h. Data is the number of events
+ * merged into the request, saturated at EVT_MERGED_MAX, and every event
+ * takes the next sequence number of the node. Together with the epoch this
+ * makes every name unique, so no request is answered from a cache in place
+ * of a new event.
+ */
+static void request_name(const evt_t *events, const unsigned *merged, unsigned n,
+                         char *name, size_t len)
+{
+    static uint16_t epoch = 0;
+    static uint8_t sequ = 0;
+    cmd_t cmds[EVT_LIMITS];
+    uint8_t frame[EVT_CODEC_FRAME_LEN(EVT_LIMITS)];
+    char hex[2 * sizeof(frame) + 1];
+
+    if (!epoch) {
+        timex_t now;
+        vtimer_now(&now);
+        epoch = evt_epoch((uint32_t) timex_uint64(now));
+    }
+
+    for (unsigned i = 0; i < n; i++) {
+        cmds[i].dst = EVT_DST;
+        cmds[i].id = events[i];
+        cmds[i].data = (merged[i] > EVT_MERGED_MAX) ? EVT_MERGED_MAX : merged[i];
+        cmds[i].sequ = sequ++;
+    }
+
+    int frame_len = evt_encode(cmds, n, epoch, frame, sizeof(frame));
+    evt_to_hex(frame, frame_len, hex, sizeof(hex));
+    snprintf(name, len, "/riot/appserver/test/%s", hex);
+}
+
+/* the events are always in the order of limits[], see flush_events() */
+static void send_request(evt_limit_t **due, unsigned n)
+{
+    evt_t events[EVT_LIMITS];
+    unsigned merged[EVT_LIMITS];
+    char name[EVT_NAME_LEN];
+
+    for (unsigned i = 0; i < n; i++) {
+        evt_limit_t *l = due[i];
+        events[i] = l->event;
+        merged[i] = l->suppressed;
+        vtimer_now(&l->last);
+        l->sent = 1;
+        l->suppressed = 0;
+    }
+
+    request_name(events, merged, n, name, sizeof(name));
+    ++evt_requests;
+
+    puts("send interest");
+    state = WAITING;
+    if (interest(name) < 0) {
+        puts("no request context free, request dropped");
+    }
+}
+
+/* send merged requests whose interval is over, returns the time in us
+ * until the next one is due or 0 if nothing is waiting */
+static uint32_t flush_events(void)
+{
+    evt_limit_t *due[EVT_LIMITS];
+    unsigned n = 0;
+    uint32_t next = 0;
+
+    for (unsigned i = 0; i < EVT_LIMITS; i++) {
+        evt_limit_t *l = &limits[i];
+        if (!l->suppressed) {
+            continue;
+        }
+        uint32_t elapsed = time_since(l);
+        if (elapsed >= l->interval) {
+            due[n++] = l;
+        }
+        else if (!next || l->interval - elapsed < next) {
+            next = l->interval - elapsed;
+        }
+    }
+
+    /* everything that is due goes out in a single batch */
+    if (n) {
+        send_request(due, n);
+    }
+    return next;
+}
 
 void send_event(evt_t event)
 {
-    static const char *riot_interest = "/riot/appserver/test";
-    switch (event) {
-        case CONFIRM:
-            break;
-        case WARN:
-        case ALARM:
-            if (state != READY) {
-                puts("send interest");
-                state = WAITING;
-                interest(riot_interest);
-            }
-            break;
-        default:
-            puts("What the heck???");
-            break;
+    evt_limit_t *l = NULL;
+
+    for (unsigned i = 0; i < EVT_LIMITS; i++) {
+        if (limits[i].event == event) {
+            l = &limits[i];
+        }
+    }
+    if (l == NULL) {
+        puts("What the heck???");
+        return;
+    }
+
+    if (!l->suppressed && time_since(l) >= l->interval) {
+        send_request(&l, 1);
+    }
+    else {
+        /* merged into the next request of this type */
+        ++l->suppressed;
+        ++evt_merged;
     }
 }
@@ -21,6 +21,45 @@
 #ifndef __EVT_HANDLER_H
 #define __EVT_HANDLER_H
 
+#include <stdint.h>
+
+/**
+ * @brief       Counters of the event dispatcher
+ */
+typedef struct {
+    unsigned depth;         /**< events currently waiting */
+    unsigned peak;          /**< maximum number of waiting events */
+    unsigned posted;        /**< events accepted so far */
+    unsigned dropped;       /**< events dropped because the queue was full */
+    unsigned requests;      /**< requests sent to the network */
+    unsigned merged;        /**< events merged into a later request */
+} evt_handler_stats_t;
+
+/**
+ * @brief       Start the thread dispatching events to the network, so the
+ *              sensor thread never waits for the radio.
+ */
+void evt_handler_init(void);
+
+/**
+ * @brief       Get the counters of the event dispatcher.
+ */
+void evt_handler_stats(evt_handler_stats_t *stats);
+
+/** longest interval that can be set, in ms */
+#define EVT_INTERVAL_MAX_MS     (UINT32_MAX / 1000)
+
+/**
+ * @brief       Set the minimum interval between two requests for one type
+ *              of event.
+ *
+ * @param[in] name  event type: "ok", "warn" or "alarm"
+ * @param[in] ms    interval in milliseconds, at most EVT_INTERVAL_MAX_MS
+ *
+ * @return      0 on success, -1 for an unknown event type or a too long
+ *              interval
+ */
+int evt_handler_set_interval(const char *name, uint32_t ms);
 
 void evt_handler_ok(void);
 void evt_handler_warn(void);
@@ -0,0 +1,667 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup     cebit_sensor
+ * @{
+ *
+ * @file        fetch.c
+ * @brief       CeBIT 2014 demo application - asynchronous interests
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+
+#include "thread.h"
+#include "msg.h"
+#include "vtimer.h"
+#include "kernel.h"
+#include "irq.h"
+#include "random.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+#include "ccn_lite/ccnl-riot.h"
+
+#include "fetch.h"
+#include "rtt.h"
+
+#define FETCH_PRIO          (PRIORITY_MAIN - 1)
+#define FETCH_MSG_QUEUE     (8)
+#define FETCH_NAME_LEN      (64)
+
+/* lanes build interests with ccn-lite's packet helpers and wait for
+ * messages, which takes a regular thread stack. ps shows what they use. */
+#ifndef FETCH_LANE_STACKSIZE
+#define FETCH_LANE_STACKSIZE    (KERNEL_CONF_STACKSIZE_DEFAULT)
+#endif
+#define LANE_MSG_QUEUE      (4)
+
+/* an interest is sent again after the retransmission timeout of its
+ * prefix, see rtt.h, the chunk fails after this many retransmissions */
+#define FETCH_MAX_RETRIES   (3)
+
+/* the relay forgets an interest after this long (us), no reply to it can
+ * come in later */
+#ifndef FETCH_INTEREST_LIFETIME
+#define FETCH_INTEREST_LIFETIME (4 * 1000 * 1000)
+#endif
+
+#define MSG_FETCH_WAKEUP    (0x5305)
+#define MSG_FETCH_LANE_GET  (0x5306)
+#define MSG_FETCH_LANE_DONE (0x5307)
+#define MSG_FETCH_LANE_ABORT (0x5308)
+
+/* a request goes on while its status is FETCH_PENDING */
+#define FETCH_PENDING       (1)
+
+/* ctx->last until the first chunk that is not full came in */
+#define FETCH_LAST_UNKNOWN  (UINT_MAX)
+
+typedef enum {
+    CTX_FREE,
+    CTX_SETUP,              /* taken, but not yet seen by the worker */
+    CTX_ACTIVE
+} ctx_state_t;
+
+typedef struct {
+    volatile ctx_state_t state;
+    int handle;
+    volatile int cancelled;
+    unsigned window;
+    fetch_chunk_cb_t chunk_cb;
+    fetch_cb_t cb;
+    void *arg;
+    int pid;
+    unsigned next;          /* next chunk to request */
+    unsigned deliver;       /* next chunk to hand over */
+    unsigned busy;          /* lanes working for this request */
+    unsigned last;          /* last chunk of the content */
+    int len;                /* bytes handed over */
+    char name[FETCH_NAME_LEN];
+    char *comp[CCNL_MAX_NAME_COMP];
+    int ncomp;
+} fetch_ctx_t;
+
+typedef enum {
+    LANE_IDLE,
+    LANE_WAITING,           /* interest sent, the lane waits for the reply */
+    LANE_READY              /* reply or error kept until it is consumed */
+} lane_state_t;
+
+typedef struct {
+    int pid;
+    lane_state_t state;     /* owned by the worker */
+    fetch_ctx_t *ctx;       /* NULL once the request is over */
+    unsigned seq;
+    int status;
+    riot_ccnl_msg_t *reply;
+    unsigned stale;         /* interests whose reply was not waited for */
+    timex_t sent;           /* last transmission */
+    volatile int abort;     /* the chunk is not needed anymore */
+    vtimer_t timer;
+    uint32_t rto;           /* retransmission timeout of the first try */
+    unsigned retries;
+    uint32_t rtt;           /* 0 if the reply is ambiguous */
+    rtt_entry_t *rtt_entry;
+    uint32_t rtt_key;
+    char name[FETCH_NAME_LEN + 12];
+    char *comp[CCNL_MAX_NAME_COMP];
+    unsigned char interest_pkt[PAYLOAD_SIZE];
+    riot_ccnl_msg_t interest_msg;
+    msg_t msg_q[LANE_MSG_QUEUE];
+} fetch_lane_t;
+
+char fetch_stack[KERNEL_CONF_STACKSIZE_MAIN];
+char fetch_lane_stack[FETCH_WINDOW_MAX][FETCH_LANE_STACKSIZE];
+static int fetch_pid;
+static msg_t fetch_msg_q[FETCH_MSG_QUEUE];
+static int fetch_relay_pid;
+static fetch_lane_t lanes[FETCH_WINDOW_MAX];
+
+/* contexts are taken by any thread, the worker owns active contexts until
+ * they are completed */
+static fetch_ctx_t pool[FETCH_POOL_SIZE];
+static int fetch_next_handle = 0;
+static fetch_stats_t stats;
+
+static void fetch_wakeup(void)
+{
+    msg_t m;
+    m.type = MSG_FETCH_WAKEUP;
+    msg_try_send(&m, fetch_pid);
+}
+
+static int fetch_new(const char *name, unsigned window, fetch_chunk_cb_t chunk_cb,
+                     fetch_cb_t cb, void *arg, int pid)
+{
+    fetch_ctx_t *ctx = NULL;
+    unsigned irq_state = disableIRQ();
+
+    for (unsigned i = 0; i < FETCH_POOL_SIZE; i++) {
+        if (pool[i].state == CTX_FREE) {
+            ctx = &pool[i];
+            ctx->state = CTX_SETUP;
+            break;
+        }
+    }
+    if (ctx == NULL) {
+        ++stats.exhausted;
+        restoreIRQ(irq_state);
+        return -1;
+    }
+    if (++fetch_next_handle <= 0) {
+        fetch_next_handle = 1;
+    }
+    ctx->handle = fetch_next_handle;
+    ++stats.started;
+    if (++stats.in_use > stats.peak) {
+        stats.peak = stats.in_use;
+    }
+    restoreIRQ(irq_state);
+
+    ctx->cancelled = 0;
+    ctx->window = (window < 1) ? 1 : (window > FETCH_WINDOW_MAX) ? FETCH_WINDOW_MAX : window;
+    ctx->chunk_cb = chunk_cb;
+    ctx->cb = cb;
+    ctx->arg = arg;
+    ctx->pid = pid;
+    ctx->next = 0;
+    ctx->deliver = 0;
+    ctx->busy = 0;
+    ctx->last = FETCH_LAST_UNKNOWN;
+    ctx->len = 0;
+    strncpy(ctx->name, name, sizeof(ctx->name) - 1);
+    ctx->name[sizeof(ctx->name) - 1] = '\0';
+
+    char *save;
+    ctx->ncomp = 0;
+    char *cp = strtok_r(ctx->name, "/", &save);
+    while (ctx->ncomp < (CCNL_MAX_NAME_COMP - 2) && cp) {
+        ctx->comp[ctx->ncomp++] = cp;
+        cp = strtok_r(NULL, "/", &save);
+    }
+
+    int handle = ctx->handle;
+    ctx->state = CTX_ACTIVE;
+    fetch_wakeup();
+    return handle;
+}
+
+int fetch_start(const char *name, fetch_chunk_cb_t chunk, fetch_cb_t done, void *arg)
+{
+    return fetch_new(name, 1, chunk, done, arg, 0);
+}
+
+int fetch_start_msg(const char *name, int pid)
+{
+    return fetch_new(name, 1, NULL, NULL, NULL, pid);
+}
+
+int fetch_stream(const char *name, unsigned window, fetch_chunk_cb_t chunk,
+                 fetch_cb_t done, void *arg)
+{
+    return fetch_new(name, window, chunk, done, arg, 0);
+}
+
+int fetch_cancel(int handle)
+{
+    int res = -1;
+    unsigned irq_state = disableIRQ();
+
+    for (unsigned i = 0; i < FETCH_POOL_SIZE; i++) {
+        fetch_ctx_t *ctx = &pool[i];
+        if (ctx->state == CTX_ACTIVE && ctx->handle == handle && !ctx->cancelled) {
+            ctx->cancelled = 1;
+            res = 0;
+        }
+    }
+    restoreIRQ(irq_state);
+
+    if (res == 0) {
+        fetch_wakeup();
+    }
+    return res;
+}
+
+void fetch_stats(fetch_stats_t *s)
+{
+    *s = stats;
+}
+
+/* replies carry no name, so the lane cannot tell a late reply to the
+ * interest of an earlier chunk from the reply to its current one. Throw
+ * away what is still on its way to this lane before the next interest is
+ * sent, i.e. until the relay has forgotten the last one. */
+static void lane_drain(fetch_lane_t *lane)
+{
+    timex_t now;
+    msg_t m;
+
+    vtimer_now(&now);
+    uint64_t since = timex_uint64(timex_sub(now, lane->sent));
+    if (since >= FETCH_INTEREST_LIFETIME) {
+        lane->stale = 0;
+        return;
+    }
+
+    vtimer_set_msg(&lane->timer, timex_set(0, FETCH_INTEREST_LIFETIME - since),
+                   lane->pid, NULL);
+    while (lane->stale) {
+        msg_receive(&m);
+        if (m.type == CCNL_RIOT_MSG) {
+            ccnl_free(m.content.ptr);
+            --lane->stale;
+        }
+        else if (m.type == CCNL_RIOT_NACK) {
+            --lane->stale;
+        }
+        else if (m.type == MSG_TIMER) {
+            DEBUG("fetch: %u replies never came\n", lane->stale);
+            lane->stale = 0;
+            return;
+        }
+        else if (m.type == MSG_FETCH_LANE_ABORT && lane->abort) {
+            /* nothing is sent, the rest is drained next time */
+            break;
+        }
+    }
+    vtimer_remove(&lane->timer);
+}
+
+static void lane_send(fetch_lane_t *lane)
+{
+    msg_t m;
+
+    /* every transmission needs a fresh nonce, or the relay takes it for a
+     * looping interest */
+    unsigned int nonce = genrand_uint32();
+    lane->interest_msg.payload = lane->interest_pkt;
+    lane->interest_msg.size = mkInterest(lane->comp, &nonce, lane->interest_pkt);
+
+    m.type = CCNL_RIOT_MSG;
+    m.content.ptr = (char *) &lane->interest_msg;
+    msg_send(&m, fetch_relay_pid);
+}
+
+/* request the chunk named by lane_request() and wait for the reply, the
+ * interest is sent again with exponential backoff if it times out */
+static int lane_get(fetch_lane_t *lane)
+{
+    timex_t sent, now;
+    msg_t m;
+
+    if (lane->stale) {
+        lane_drain(lane);
+    }
+
+    lane->rtt = 0;
+    for (lane->retries = 0; ; lane->retries++) {
+        /* the abort message may have been taken by lane_drain() */
+        if (lane->abort) {
+            return FETCH_CANCELLED;
+        }
+        lane_send(lane);
+        vtimer_now(&sent);
+        lane->sent = sent;
+        vtimer_set_msg(&lane->timer, timex_set(0, rtt_timeout(lane->rto, lane->retries)),
+                       lane->pid, NULL);
+
+        do {
+            msg_receive(&m);
+        } while (m.type != CCNL_RIOT_MSG && m.type != CCNL_RIOT_NACK && m.type != MSG_TIMER &&
+                 !(m.type == MSG_FETCH_LANE_ABORT && lane->abort));
+
+        if (m.type == MSG_FETCH_LANE_ABORT) {
+            vtimer_remove(&lane->timer);
+            lane->stale = lane->retries + 1;
+            return FETCH_CANCELLED;
+        }
+
+        /* replies to the earlier transmissions may still be on their way */
+        if (m.type == CCNL_RIOT_MSG) {
+            vtimer_remove(&lane->timer);
+            lane->reply = (riot_ccnl_msg_t *) m.content.ptr;
+            lane->stale = lane->retries;
+            if (lane->retries == 0) {
+                vtimer_now(&now);
+                lane->rtt = timex_uint64(timex_sub(now, sent));
+            }
+            return FETCH_OK;
+        }
+        if (m.type == CCNL_RIOT_NACK) {
+            vtimer_remove(&lane->timer);
+            lane->stale = lane->retries;
+            return FETCH_NACK;
+        }
+        if (lane->retries == FETCH_MAX_RETRIES) {
+            lane->stale = lane->retries + 1;
+            return FETCH_TIMEOUT;
+        }
+    }
+}
+
+static void *fetch_lane(void *arg)
+{
+    fetch_lane_t *lane = arg;
+    msg_t m;
+
+    msg_init_queue(lane->msg_q, LANE_MSG_QUEUE);
+
+    for (;;) {
+        msg_receive(&m);
+        switch (m.type) {
+            case MSG_FETCH_LANE_GET:
+                lane->status = lane_get(lane);
+                m.type = MSG_FETCH_LANE_DONE;
+                m.content.ptr = (char *) lane;
+                msg_send(&m, fetch_pid);
+                break;
+            case CCNL_RIOT_MSG:
+                /* late reply to an interest given up on */
+                ccnl_free(m.content.ptr);
+                /* fall through */
+            case CCNL_RIOT_NACK:
+                if (lane->stale) {
+                    --lane->stale;
+                }
+                break;
+            default:
+                /* e.g. an abort that came after the chunk */
+                break;
+        }
+    }
+    return NULL;
+}
+
+static void lane_request(fetch_lane_t *lane, fetch_ctx_t *ctx)
+{
+    char *p = lane->name;
+    int i;
+
+    /* the name is copied, the lane must not look at the context as it may
+     * be over before the lane gets to run */
+    for (i = 0; i < ctx->ncomp; i++) {
+        lane->comp[i] = p;
+        strcpy(p, ctx->comp[i]);
+        p += strlen(p) + 1;
+    }
+    lane->comp[i] = p;
+    lane->comp[i + 1] = NULL;
+    snprintf(p, 12, "%u", ctx->next);
+
+    lane->rtt_entry = rtt_lookup(ctx->comp, ctx->ncomp);
+    lane->rtt_key = lane->rtt_entry->key;
+    lane->rto = lane->rtt_entry->rto;
+
+    lane->state = LANE_WAITING;
+    lane->abort = 0;
+    lane->reply = NULL;
+    lane->ctx = ctx;
+    lane->seq = ctx->next++;
+    ++ctx->busy;
+
+    msg_t m;
+    m.type = MSG_FETCH_LANE_GET;
+    msg_send(&m, lane->pid);
+}
+
+static void lane_release(fetch_lane_t *lane)
+{
+    if (lane->reply) {
+        ccnl_free(lane->reply);
+        lane->reply = NULL;
+    }
+    lane->ctx = NULL;
+    lane->state = LANE_IDLE;
+}
+
+/* stop a waiting lane, it reports FETCH_CANCELLED unless it is done already */
+static void lane_abort(fetch_lane_t *lane)
+{
+    msg_t m;
+
+    lane->abort = 1;
+    m.type = MSG_FETCH_LANE_ABORT;
+    msg_try_send(&m, lane->pid);
+}
+
+static fetch_lane_t *lane_find(lane_state_t state, fetch_ctx_t *ctx, unsigned seq)
+{
+    fetch_lane_t *found = NULL;
+
+    for (unsigned i = 0; i < FETCH_WINDOW_MAX; i++) {
+        fetch_lane_t *lane = &lanes[i];
+        if (lane->state != state) {
+            continue;
+        }
+        if (state != LANE_IDLE) {
+            if (lane->ctx == ctx && lane->seq == seq) {
+                return lane;
+            }
+        }
+        else if (!lane->stale) {
+            return lane;
+        }
+        else if (found == NULL) {
+            /* has to wait for late replies before it can send, see
+             * lane_drain() */
+            found = lane;
+        }
+    }
+    return found;
+}
+
+/* a lane finished, lanes of requests that are over are freed right away */
+static void lane_done(msg_t *m)
+{
+    fetch_lane_t *lane = (fetch_lane_t *) m->content.ptr;
+
+    /* the entry may have been taken over by another prefix meanwhile */
+    if (lane->rtt_entry->key == lane->rtt_key) {
+        if (lane->rtt) {
+            rtt_sample(lane->rtt_entry, lane->rtt);
+        }
+        rtt_retransmit(lane->rtt_entry, lane->retries);
+    }
+    stats.retransmits += lane->retries;
+
+    lane->state = LANE_READY;
+    fetch_ctx_t *ctx = lane->ctx;
+    if (ctx == NULL) {
+        lane_release(lane);
+        return;
+    }
+
+    /* the last chunk is the first one that is not full, lanes sent out for
+     * chunks behind it are stopped */
+    if (lane->status == FETCH_OK && lane->reply->size < CCNL_RIOT_CHUNK_SIZE - 1 &&
+        lane->seq < ctx->last) {
+        ctx->last = lane->seq;
+        for (unsigned i = 0; i < FETCH_WINDOW_MAX; i++) {
+            if (lanes[i].ctx == ctx && lanes[i].state == LANE_WAITING &&
+                lanes[i].seq > ctx->last) {
+                lane_abort(&lanes[i]);
+            }
+        }
+    }
+}
+
+/* hand the lanes out to the active requests one at a time, so that a
+ * request with a large window does not starve the others. Until the first
+ * chunk is in, the content may be a single chunk, so only that one is
+ * asked for. */
+static void fetch_fill(void)
+{
+    static unsigned first = 0;
+    int progress;
+
+    do {
+        progress = 0;
+        for (unsigned i = 0; i < FETCH_POOL_SIZE; i++) {
+            fetch_ctx_t *ctx = &pool[(first + i) % FETCH_POOL_SIZE];
+            if (ctx->state != CTX_ACTIVE || ctx->cancelled || ctx->next > ctx->last) {
+                continue;
+            }
+            unsigned window = (ctx->deliver == 0) ? 1 : ctx->window;
+            if (ctx->busy >= window) {
+                continue;
+            }
+            fetch_lane_t *lane = lane_find(LANE_IDLE, NULL, 0);
+            if (lane == NULL) {
+                return;
+            }
+            lane_request(lane, ctx);
+            progress = 1;
+        }
+    } while (progress);
+    ++first;
+}
+
+static void fetch_release(void *ref)
+{
+    ccnl_free(ref);
+}
+
+/* hand the chunk over to the consumer, together with the buffer the relay
+ * allocated for it */
+static int fetch_deliver(fetch_ctx_t *ctx, fetch_lane_t *lane)
+{
+    fetch_chunk_t chunk;
+
+    if (lane->status != FETCH_OK) {
+        return lane->status;
+    }
+
+    int size = lane->reply->size;
+    chunk.seq = lane->seq;
+    chunk.data = lane->reply->payload;
+    chunk.len = size;
+    chunk.ref = lane->reply;
+    chunk.release = fetch_release;
+    lane->reply = NULL;
+
+    int res = 0;
+    if (ctx->chunk_cb) {
+        res = ctx->chunk_cb(ctx->handle, &chunk, ctx->arg);
+    }
+    else {
+        fetch_release(chunk.ref);
+    }
+    if (res < 0) {
+        return res;
+    }
+    ctx->len += size;
+    if (res > 0 || size < CCNL_RIOT_CHUNK_SIZE - 1) {
+        /* the last chunk is the first one that is not full */
+        return FETCH_OK;
+    }
+    return FETCH_PENDING;
+}
+
+static void fetch_complete(fetch_ctx_t *ctx, int status)
+{
+    /* chunks past the end or after an error are of no use anymore, lanes
+     * still waiting are stopped and freed once they are done */
+    for (unsigned i = 0; i < FETCH_WINDOW_MAX; i++) {
+        if (lanes[i].ctx == ctx) {
+            if (lanes[i].state == LANE_READY) {
+                lane_release(&lanes[i]);
+            }
+            else {
+                lanes[i].ctx = NULL;
+                lane_abort(&lanes[i]);
+            }
+        }
+    }
+
+    if (status != FETCH_OK) {
+        ++stats.failed;
+    }
+
+    if (ctx->cb) {
+        ctx->cb(ctx->handle, status, ctx->len, ctx->arg);
+    }
+    else if (ctx->pid) {
+        msg_t m;
+        m.type = (status == FETCH_OK) ? MSG_FETCH_DONE : MSG_FETCH_FAILED;
+        m.content.value = ctx->handle;
+        msg_try_send(&m, ctx->pid);
+    }
+
+    unsigned irq_state = disableIRQ();
+    ctx->state = CTX_FREE;
+    --stats.in_use;
+    restoreIRQ(irq_state);
+}
+
+/* request <name>/0, <name>/1, ... until a chunk is not full, with up to
+ * ctx->window chunks outstanding */
+static void fetch_progress(fetch_ctx_t *ctx)
+{
+    fetch_lane_t *lane;
+    int status = ctx->cancelled ? FETCH_CANCELLED : FETCH_PENDING;
+
+    while (status == FETCH_PENDING &&
+           (lane = lane_find(LANE_READY, ctx, ctx->deliver))) {
+        status = fetch_deliver(ctx, lane);
+        lane_release(lane);
+        --ctx->busy;
+        ++ctx->deliver;
+    }
+
+    if (status != FETCH_PENDING) {
+        fetch_complete(ctx, status);
+    }
+}
+
+static void *fetch_worker(void *arg)
+{
+    (void) arg;
+    msg_t m;
+
+    msg_init_queue(fetch_msg_q, FETCH_MSG_QUEUE);
+
+    for (;;) {
+        fetch_fill();
+
+        msg_receive(&m);
+        if (m.type == MSG_FETCH_LANE_DONE) {
+            lane_done(&m);
+        }
+
+        for (unsigned i = 0; i < FETCH_POOL_SIZE; i++) {
+            if (pool[i].state == CTX_ACTIVE) {
+                fetch_progress(&pool[i]);
+            }
+        }
+    }
+    return NULL;
+}
+
+void fetch_init(int relay_pid)
+{
+    if (fetch_pid) {
+        /* already running */
+        return;
+    }
+
+    fetch_relay_pid = relay_pid;
+    fetch_pid = thread_create(fetch_stack, sizeof(fetch_stack), FETCH_PRIO,
+                              CREATE_STACKTEST, fetch_worker, NULL, "fetch");
+
+    for (unsigned i = 0; i < FETCH_WINDOW_MAX; i++) {
+        lanes[i].state = LANE_IDLE;
+        lanes[i].pid = thread_create(fetch_lane_stack[i], FETCH_LANE_STACKSIZE, FETCH_PRIO,
+                                     CREATE_STACKTEST, fetch_lane, &lanes[i], "fetchlane");
+    }
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup     cebit_sensor
+ * @{
+ *
+ * @file        fetch.h
+ * @brief       CeBIT 2014 demo application - asynchronous interests
+ *
+ * Every request takes a context from a fixed pool, which holds its name, so
+ * that several requests can be in flight at once. The chunks are fetched
+ * by a worker thread and the caller returns immediately. Completion is
+ * reported either to a callback, which runs on the worker thread, or as a
+ * message to a thread.
+ *
+ * Content is never copied: consumers get a reference to the chunk in the
+ * buffer the relay allocated for it and release it when they are done.
+ *
+ * Up to FETCH_WINDOW_MAX chunk interests of a request can be outstanding at
+ * a time. Replies from the relay carry no name, so each outstanding chunk
+ * is handled by a lane thread of its own, i.e. by its own relay face. The
+ * chunks are reordered and handed to the consumer in sequence.
+ *
+ * @}
+ */
+
+#ifndef __FETCH_H
+#define __FETCH_H
+
+#include <stdint.h>
+
+/** message types sent on completion, content.value is the request handle */
+#define MSG_FETCH_DONE      (0x5303)
+#define MSG_FETCH_FAILED    (0x5304)
+
+/**
+ * maximum number of outstanding chunk interests, one lane thread each. A
+ * lane takes FETCH_LANE_STACKSIZE of stack plus its interest buffer, so
+ * raise this only where the RAM is there.
+ */
+#ifndef FETCH_WINDOW_MAX
+#define FETCH_WINDOW_MAX    (4)
+#endif
+
+/** number of request contexts */
+#ifndef FETCH_POOL_SIZE
+#define FETCH_POOL_SIZE     (4)
+#endif
+
+/** status passed to the completion callback */
+#define FETCH_OK            (0)
+#define FETCH_NACK          (-1)    /**< the relay could not get a chunk */
+#define FETCH_TIMEOUT       (-2)    /**< no reply, even after retransmitting */
+#define FETCH_CANCELLED     (-3)    /**< fetch_cancel() was called */
+
+/**
+ * @brief       Counters of the context pool
+ */
+typedef struct {
+    unsigned in_use;        /**< contexts taken right now */
+    unsigned peak;          /**< most contexts ever taken at once */
+    unsigned exhausted;     /**< requests refused as no context was free */
+    unsigned started;       /**< requests accepted */
+    unsigned failed;        /**< requests that did not complete with FETCH_OK */
+    unsigned retransmits;   /**< chunk interests sent again after a timeout */
+} fetch_stats_t;
+
+/**
+ * @brief       A chunk of content, still in the relay's buffer
+ */
+typedef struct {
+    unsigned seq;           /**< number of the chunk */
+    char *data;             /**< the chunk */
+    int len;                /**< length of the chunk */
+    void *ref;              /**< buffer holding the chunk */
+    void (*release)(void *ref);     /**< frees the buffer */
+} fetch_chunk_t;
+
+/**
+ * @brief       Completion callback, called on the worker thread
+ *
+ * @param[in] handle    handle returned by fetch_start()
+ * @param[in] status    FETCH_OK or one of the error codes
+ * @param[in] len       number of bytes handed to the consumer
+ * @param[in] arg       argument given to fetch_start()
+ */
+typedef void (*fetch_cb_t)(int handle, int status, int len, void *arg);
+
+/**
+ * @brief       Chunk consumer, called on the worker thread in chunk order
+ *
+ * The consumer owns the chunk and has to call chunk->release(chunk->ref)
+ * once it is done with the data, which may be after returning.
+ *
+ * @param[in] handle    handle returned by fetch_start()
+ * @param[in] chunk     the chunk
+ * @param[in] arg       argument given to fetch_start()
+ *
+ * @return      0 to go on, > 0 to stop early with FETCH_OK or one of the
+ *              error codes to abort
+ */
+typedef int (*fetch_chunk_cb_t)(int handle, const fetch_chunk_t *chunk, void *arg);
+
+/**
+ * @brief       Start the worker and lane threads.
+ *
+ * @param[in] relay_pid     thread id of the ccn-lite relay
+ */
+void fetch_init(int relay_pid);
+
+/**
+ * @brief       Queue an interest, completion is reported to a callback.
+ *
+ * Same as fetch_stream() with a window of one chunk.
+ *
+ * @param[in] name      name of the content, e.g. /riot/appserver/test
+ * @param[in] chunk     chunk consumer, NULL to drop the content
+ * @param[in] done      completion callback, may be NULL
+ * @param[in] arg       passed on to both callbacks
+ *
+ * @return      a handle for fetch_cancel(), -1 if no context is free
+ */
+int fetch_start(const char *name, fetch_chunk_cb_t chunk, fetch_cb_t done, void *arg);
+
+/**
+ * @brief       Queue an interest, completion is reported as a message.
+ *
+ * Thread @p pid gets MSG_FETCH_DONE or MSG_FETCH_FAILED with the handle
+ * as content.value. The message is dropped if @p pid cannot take it. The
+ * content itself is dropped.
+ *
+ * @return      a handle for fetch_cancel(), -1 if no context is free
+ */
+int fetch_start_msg(const char *name, int pid);
+
+/**
+ * @brief       Queue an interest whose content is streamed to a consumer.
+ *
+ * Content of any size can be fetched this way. @p done is called once the
+ * last chunk was handed to the consumer.
+ *
+ * @param[in] name      name of the content
+ * @param[in] window    chunk interests outstanding at a time, capped to
+ *                      FETCH_WINDOW_MAX
+ * @param[in] chunk     chunk consumer, NULL to drop the content
+ * @param[in] done      completion callback, may be NULL
+ * @param[in] arg       passed on to both callbacks
+ *
+ * @return      a handle for fetch_cancel(), -1 if no context is free
+ */
+int fetch_stream(const char *name, unsigned window, fetch_chunk_cb_t chunk,
+                 fetch_cb_t done, void *arg);
+
+/**
+ * @brief       Cancel a queued or running request.
+ *
+ * The completion is reported with FETCH_CANCELLED.
+ *
+ * @return      0 on success, -1 if the request is unknown or finished
+ */
+int fetch_cancel(int handle);
+
+/**
+ * @brief       Get the counters of the context pool.
+ */
+void fetch_stats(fetch_stats_t *stats);
+
+#endif /* __FETCH_H */
@@ -40,9 +40,19 @@
 #include "ccn_lite/util/ccnl-riot-client.h"
 
 #include "../events.h"
+#include "sense.h"
+#include "evt_handler.h"
+#include "stream.h"
+#include "fetch.h"
+#include "rtt.h"
+#include "bench.h"
 
 #define RIOT_CCN_APPSERVER (1)
 #define RIOT_CCN_TESTS (0)
+/* print the content of interests, otherwise it is dropped right away */
+#define INTEREST_PRINT (1)
+
+#define NODE_ADDR (3)
 
 long long relay_stack[KERNEL_CONF_STACKSIZE_MAIN];
 long long blinker_stack[KERNEL_CONF_STACKSIZE_DEFAULT];
@@ -55,10 +65,12 @@ int relay_pid, appserver_pid;
 #define SHELL_MSG_BUFFER_SIZE (64)
 msg_t msg_buffer_shell[SHELL_MSG_BUFFER_SIZE];
 
-shell_t shell;
+/* replies of the relay to control requests from the shell, which do not
+ * say how much they write, sized like the content buffer they once shared */
+#define SHELL_REPLY_SIZE (3 * 1024)
+static unsigned char shell_reply[SHELL_REPLY_SIZE];
 
-unsigned char big_buf[3 * 1024];
-char small_buf[PAYLOAD_SIZE];
+shell_t shell;
 
 state_t state = IDLE;
 
@@ -82,43 +94,158 @@ static void riot_ccn_appserver(int argc, char **argv)
 }
 #endif
 
-void interest(const char *argv);
+int interest(const char *name);
 
 static void riot_ccn_express_interest(int argc, char **argv)
 {
     static const char *default_interest = "/ccnx/0.7.1/doc/technical/CanonicalOrder.txt";
 
+    int handle = interest((argc < 2) ? default_interest : argv[1]);
+
+    if (handle < 0) {
+        puts("no request context free");
+        return;
+    }
+    printf("interest %d pending\n", handle);
+}
+
+static void riot_ccn_cancel_interest(int argc, char **argv)
+{
     if (argc < 2) {
-        interest(default_interest);
+        printf("usage: %s <handle>\n", argv[0]);
+        return;
     }
-    else {
-        interest(argv[1]);
+
+    if (fetch_cancel(atoi(argv[1])) < 0) {
+        puts("no such interest");
     }
 }
 
-void interest(const char *argv)
+#if INTEREST_PRINT
+/* prints the chunks as they come in, straight from the relay's buffer */
+static int interest_print(int handle, const fetch_chunk_t *chunk, void *arg)
 {
-    strncpy(small_buf, argv, strlen(argv)); // null terminated
-    DEBUG("in='%s'\n", small_buf);
+    (void) handle;
+    (void) arg;
 
-    /* for demo cases */
-    vtimer_usleep(300 * 1000);
+    if (chunk->seq == 0) {
+        puts("####################################################");
+        printf("data='");
+    }
+    printf("%.*s", chunk->len, chunk->data);
+    chunk->release(chunk->ref);
+    return 0;
+}
+#else
+#define interest_print NULL
+#endif
 
-    int content_len = ccnl_riot_client_get(relay_pid, small_buf, (char *) big_buf); // small_buf=name to request
+static void interest_done(int handle, int status, int len, void *arg)
+{
+    (void) arg;
 
-    if (content_len == 0) {
-        puts("riot_get returned 0 bytes...aborting!");
+#if INTEREST_PRINT
+    if (len > 0) {
+        puts("'");
+        puts("####################################################");
+    }
+#endif
+    if (status != FETCH_OK || len == 0) {
+        printf("interest %d failed (%d)...aborting!\n", handle, status);
         return;
     }
 
-    puts("####################################################");
-    big_buf[content_len] = '\0';
-    printf("data='%s'\n", big_buf);
-    puts("####################################################");
-    puts("done");
+    printf("interest %d done, %d bytes\n", handle, len);
     state = READY;
 }
 
+/* returns immediately, the content is printed once it arrived */
+int interest(const char *name)
+{
+    DEBUG("in='%s'\n", name);
+    return fetch_start(name, interest_print, interest_done, NULL);
+}
+
+/* shell fetch: only count what arrives and report the throughput */
+static struct {
+    timex_t start;
+    unsigned chunks;
+} fetch_shell;
+
+static int fetch_shell_chunk(int handle, const fetch_chunk_t *chunk, void *arg)
+{
+    (void) handle;
+    (void) arg;
+
+    fetch_shell.chunks++;
+    chunk->release(chunk->ref);
+    return 0;
+}
+
+static void fetch_shell_done(int handle, int status, int len, void *arg)
+{
+    (void) arg;
+
+    timex_t now;
+    vtimer_now(&now);
+    uint32_t ms = timex_uint64(timex_sub(now, fetch_shell.start)) / 1000;
+
+    printf("fetch %d: status %d, %d bytes in %u chunks, %" PRIu32 " ms",
+           handle, status, len, fetch_shell.chunks, ms);
+    if (ms) {
+        printf(", %" PRIu32 " bytes/s", (uint32_t) len * 1000 / ms);
+    }
+    puts("");
+}
+
+static void riot_ccn_fetch(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("usage: %s <name> [<window>]\n", argv[0]);
+        return;
+    }
+
+    unsigned window = (argc > 2) ? atoi(argv[2]) : FETCH_WINDOW_MAX;
+    fetch_shell.chunks = 0;
+    vtimer_now(&fetch_shell.start);
+
+    int handle = fetch_stream(argv[1], window, fetch_shell_chunk, fetch_shell_done, NULL);
+    if (handle < 0) {
+        puts("no request context free");
+        return;
+    }
+    printf("fetch %d pending\n", handle);
+}
+
+static void riot_ccn_fetch_stat(int argc, char **argv)
+{
+    (void) argc; /* the function takes no arguments */
+    (void) argv;
+
+    fetch_stats_t stats;
+    fetch_stats(&stats);
+    printf("contexts: %u of %u in use, peak %u, exhausted %u\n",
+           stats.in_use, FETCH_POOL_SIZE, stats.peak, stats.exhausted);
+    printf("requests: %u started, %u failed, %u chunk retransmissions\n",
+           stats.started, stats.failed, stats.retransmits);
+}
+
+static void riot_ccn_rtt(int argc, char **argv)
+{
+    (void) argc; /* the function takes no arguments */
+    (void) argv;
+
+    puts("prefix                   srtt/ms  rttvar/ms  rto/ms  samples  retrans");
+    for (unsigned i = 0; i < RTT_ENTRIES; i++) {
+        const rtt_entry_t *e = rtt_get(i);
+        if (e == NULL) {
+            continue;
+        }
+        printf("%-24s %7" PRIu32 " %10" PRIu32 " %7" PRIu32 " %8u %8u\n", e->label,
+               e->srtt / 1000, e->rttvar / 1000, e->rto / 1000, e->samples, e->retransmits);
+    }
+}
+
 static void riot_ccn_register_prefix(int argc, char **argv)
 {
     if (argc < 4) {
@@ -126,15 +253,18 @@ static void riot_ccn_register_prefix(int argc, char **argv)
         return;
     }
 
-    strncpy(small_buf, argv[1], 100);
-    DEBUG("prefix='%s'\n", small_buf);
+    char prefix[PAYLOAD_SIZE];
+
+    strncpy(prefix, argv[1], sizeof(prefix) - 1);
+    prefix[sizeof(prefix) - 1] = '\0';
+    DEBUG("prefix='%s'\n", prefix);
 
     char *type = argv[2];
     char *faceid = argv[3]; // 0=trans;1=msg
 
-    int content_len = ccnl_riot_client_publish(relay_pid, small_buf, faceid, type, big_buf);
+    int content_len = ccnl_riot_client_publish(relay_pid, prefix, faceid, type, shell_reply);
 
-    DEBUG("shell received: '%s'\n", big_buf);
+    DEBUG("shell received: '%s'\n", shell_reply);
     DEBUG("received %d bytes.\n", content_len);
     puts("done");
 }
@@ -275,6 +405,7 @@ static void riot_ccn_pit_test(int argc, char **argv)
 
     msg_t m;
     riot_ccnl_msg_t rmsg;
+    static unsigned char interest_buf[PAYLOAD_SIZE];
     char segment_string[16]; //max=999\0
     timex_t now;
 
@@ -285,9 +416,9 @@ static void riot_ccn_pit_test(int argc, char **argv)
         snprintf(segment_string, 16, "%d", segment);
         prefix[i] = segment_string;
         unsigned int interest_nonce = genrand_uint32();
-        int interest_len = mkInterest(prefix, &interest_nonce, (unsigned char *) small_buf);
+        int interest_len = mkInterest(prefix, &interest_nonce, interest_buf);
 
-        rmsg.payload = &small_buf;
+        rmsg.payload = interest_buf;
         rmsg.size = interest_len;
         m.content.ptr = (char *) &rmsg;
         m.type = CCNL_RIOT_MSG;
@@ -310,25 +441,27 @@ static void riot_ccn_fib_test(int argc, char **argv)
 
     char type[] = "newTRANSface";
     char faceid[] = "42";
+    char prefix[PAYLOAD_SIZE];
+    unsigned char *reply = shell_reply;
 
-    riot_new_face(relay_pid, type, faceid, big_buf);
+    riot_new_face(relay_pid, type, faceid, reply);
 
     timex_t now;
     int i = -1;
 
     do {
         i++;
-        snprintf(small_buf, sizeof(small_buf), "/riot/test/fib/%d/", i);
-        riot_register_prefix(relay_pid, small_buf, faceid, big_buf);
+        snprintf(prefix, sizeof(prefix), "/riot/test/fib/%d/", i);
+        riot_register_prefix(relay_pid, prefix, faceid, reply);
 
         if (i % 50 == 0) {
             vtimer_now(&now);
             printf("done: %d - %ld.%ld\n", i, now.tv_sec, now.tv_usec);
         }
     }
-    while (0 == strcmp((const char *) big_buf, "prefixreg cmd worked"));
+    while (0 == strcmp((const char *) reply, "prefixreg cmd worked"));
 
-    DEBUG("%d: '%s'\n", i, big_buf);
+    DEBUG("%d: '%s'\n", i, reply);
     printf("done: %d\n", i - 1);
 }
 #endif
@@ -355,6 +488,66 @@ static void riot_ccn_stat(int argc, char **argv)
     msg_send(&m, relay_pid);
 }
 
+static void riot_sense_rate(int argc, char **argv)
+{
+    (void) argc; /* the function takes no arguments */
+    (void) argv;
+
+    uint32_t period = sense_get_period();
+    printf("sampling period: %" PRIu32 " us (%" PRIu32 " Hz)\n",
+           period, 1000000 / period);
+}
+
+static void riot_sense_stream(int argc, char **argv)
+{
+    if (argc == 2) {
+        if (strcmp(argv[1], "on") == 0) {
+            stream_init(relay_pid, NODE_ADDR);
+            stream_enable(1);
+        }
+        else if (strcmp(argv[1], "off") == 0) {
+            stream_enable(0);
+        }
+        else {
+            printf("usage: %s [on|off]\n", argv[0]);
+            return;
+        }
+    }
+
+    stream_stats_t stats;
+    stream_stats(&stats);
+    printf("streaming %s: %" PRIu32 " samples, %u chunks served, %u deferred, %u expired, %u busy\n",
+           stream_enabled() ? "on" : "off", stats.samples, stats.served,
+           stats.deferred, stats.expired, stats.busy);
+}
+
+static void riot_evt_stat(int argc, char **argv)
+{
+    (void) argc; /* the function takes no arguments */
+    (void) argv;
+
+    evt_handler_stats_t stats;
+    evt_handler_stats(&stats);
+    printf("events: depth %u, peak %u, posted %u, dropped %u\n",
+           stats.depth, stats.peak, stats.posted, stats.dropped);
+    printf("requests: %u, merged events: %u\n", stats.requests, stats.merged);
+}
+
+static void riot_evt_limit(int argc, char **argv)
+{
+    if (argc < 3) {
+        printf("usage: %s <ok|warn|alarm> <min interval in ms>\n", argv[0]);
+        return;
+    }
+
+    long ms = atol(argv[2]);
+    if (ms < 0 || (unsigned long) ms > EVT_INTERVAL_MAX_MS ||
+        evt_handler_set_interval(argv[1], ms) < 0) {
+        printf("unknown event type %s or interval above %lu ms\n", argv[1],
+               (unsigned long) EVT_INTERVAL_MAX_MS);
+    }
+}
+
 static void _ignore(radio_address_t a);
 transceiver_command_t tcmd;
 
@@ -378,7 +571,7 @@ static void _ignore(radio_address_t a)
     mesg.type = DBG_IGN;
     mesg.content.ptr = (char *) &tcmd;
 
-    tcmd.transceivers = TRANSCEIVER_CC1100;
+    tcmd.transceivers = TRANSCEIVER;
     tcmd.data = &a;
 
     printf("sending to transceiver (%u): %u\n", transceiver_pid, (*(uint8_t *)tcmd.data));
@@ -388,6 +581,10 @@ static void _ignore(radio_address_t a)
 static const shell_command_t sc[] = {
     { "haltccn", "stops ccn relay", riot_ccn_relay_stop },
     { "interest", "express an interest", riot_ccn_express_interest },
+    { "cancel", "cancels a pending interest", riot_ccn_cancel_interest },
+    { "fetch", "fetches content of any size with a window of chunk interests", riot_ccn_fetch },
+    { "fetchstat", "shows the counters of the request context pool", riot_ccn_fetch_stat },
+    { "rtt", "shows the round trip time estimates per prefix", riot_ccn_rtt },
     { "populate", "populate the cache of the relay with data", riot_ccn_populate },
     { "prefix", "registers a prefix to a face", riot_ccn_register_prefix },
     { "stat", "prints out forwarding statistics", riot_ccn_stat },
@@ -398,6 +595,13 @@ static const shell_command_t sc[] = {
 #if RIOT_CCN_TESTS
     { "pittest", "starts a test for the size and speed of pit operations", riot_ccn_pit_test },
     { "fibtest", "starts a test for the size and speed of fib operations", riot_ccn_fib_test },
+#endif
+    { "rate", "shows the current sampling rate of the sensor", riot_sense_rate },
+    { "stream", "streams sensor data as /riot/sensor/<node>/<seq>", riot_sense_stream },
+    { "evtstat", "shows the counters of the event dispatcher", riot_evt_stat },
+    { "evtlimit", "sets the minimum interval between requests per event type", riot_evt_limit },
+#ifdef BOARD_NATIVE
+    { "bench", "replays a trace through the tilt detection", bench_detect },
 #endif
     { "ign", "ignore node", ignore},
     { NULL, NULL, NULL }
@@ -429,9 +633,11 @@ int main(void)
         return -1;
     }
 
+    evt_handler_init();
     sense_init();
     riot_ccn_relay_start();
-    set_address(3);
+    fetch_init(relay_pid);
+    set_address(NODE_ADDR);
     _ignore(1);
     
     thread_create(blinker_stack, sizeof(blinker_stack),
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup     cebit_sensor
+ * @{
+ *
+ * @file        rtt.c
+ * @brief       CeBIT 2014 demo application - round trip time estimation
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "rtt.h"
+
+/* clock granularity in the RTO formula */
+#define RTT_GRANULARITY     (10 * 1000U)
+
+static rtt_entry_t entries[RTT_ENTRIES];
+static unsigned use_count = 0;
+
+static uint32_t rtt_hash(char **comp, int ncomp)
+{
+    uint32_t h = 5381;
+
+    for (int i = 0; i < ncomp; i++) {
+        for (const char *c = comp[i]; *c; c++) {
+            h = h * 33 + *c;
+        }
+        h = h * 33 + '/';
+    }
+    return h ? h : 1;
+}
+
+rtt_entry_t *rtt_lookup(char **comp, int ncomp)
+{
+    rtt_entry_t *e = &entries[0];
+
+    if (ncomp > RTT_PREFIX_COMPS) {
+        ncomp = RTT_PREFIX_COMPS;
+    }
+    uint32_t key = rtt_hash(comp, ncomp);
+
+    for (unsigned i = 0; i < RTT_ENTRIES; i++) {
+        if (entries[i].key == key) {
+            e = &entries[i];
+            e->last_use = ++use_count;
+            return e;
+        }
+        if (entries[i].last_use < e->last_use) {
+            e = &entries[i];
+        }
+    }
+
+    /* replace the least recently used entry */
+    memset(e, 0, sizeof(*e));
+    e->key = key;
+    e->rto = RTT_RTO_INIT;
+    e->last_use = ++use_count;
+    for (int i = 0, pos = 0; i < ncomp && pos < RTT_LABEL_LEN; i++) {
+        pos += snprintf(e->label + pos, RTT_LABEL_LEN - pos, "/%s", comp[i]);
+    }
+    return e;
+}
+
+void rtt_sample(rtt_entry_t *e, uint32_t rtt)
+{
+    if (e->samples++ == 0) {
+        e->srtt = rtt;
+        e->rttvar = rtt / 2;
+    }
+    else {
+        uint32_t delta = (e->srtt > rtt) ? e->srtt - rtt : rtt - e->srtt;
+        e->rttvar = e->rttvar - e->rttvar / 4 + delta / 4;
+        e->srtt = e->srtt - e->srtt / 8 + rtt / 8;
+    }
+
+    uint32_t var = 4 * e->rttvar;
+    e->rto = e->srtt + ((var > RTT_GRANULARITY) ? var : RTT_GRANULARITY);
+    if (e->rto < RTT_RTO_MIN) {
+        e->rto = RTT_RTO_MIN;
+    }
+    else if (e->rto > RTT_RTO_MAX) {
+        e->rto = RTT_RTO_MAX;
+    }
+}
+
+void rtt_retransmit(rtt_entry_t *e, unsigned count)
+{
+    e->retransmits += count;
+}
+
+uint32_t rtt_timeout(uint32_t rto, unsigned retries)
+{
+    /* exponential backoff */
+    while (retries-- && rto < RTT_RTO_MAX) {
+        rto *= 2;
+    }
+    return (rto > RTT_RTO_MAX) ? RTT_RTO_MAX : rto;
+}
+
+const rtt_entry_t *rtt_get(unsigned i)
+{
+    if (i >= RTT_ENTRIES || entries[i].key == 0) {
+        return NULL;
+    }
+    return &entries[i];
+}
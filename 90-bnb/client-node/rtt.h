@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup     cebit_sensor
+ * @{
+ *
+ * @file        rtt.h
+ * @brief       CeBIT 2014 demo application - round trip time estimation
+ *
+ * Smoothed RTT and RTT variance are kept per name prefix, i.e. the first
+ * RTT_PREFIX_COMPS components of a name, as in TCP (RFC 6298). The
+ * retransmission timeout derived from them is doubled with every
+ * retransmission of the same interest.
+ *
+ * @}
+ */
+
+#ifndef __RTT_H
+#define __RTT_H
+
+#include <stdint.h>
+
+/** number of prefixes tracked, the least recently used one is replaced */
+#define RTT_ENTRIES         (8)
+/** name components that make up a prefix */
+#define RTT_PREFIX_COMPS    (3)
+#define RTT_LABEL_LEN       (24)
+
+/** bounds of the retransmission timeout in us */
+#define RTT_RTO_INIT        (1000 * 1000U)
+#define RTT_RTO_MIN         (50 * 1000U)
+#define RTT_RTO_MAX         (10 * 1000 * 1000U)
+
+typedef struct {
+    uint32_t key;           /**< hash of the prefix, 0 if unused */
+    char label[RTT_LABEL_LEN];
+    uint32_t srtt;          /**< smoothed RTT in us */
+    uint32_t rttvar;        /**< RTT variance in us */
+    uint32_t rto;           /**< retransmission timeout in us */
+    unsigned samples;       /**< RTT samples taken */
+    unsigned retransmits;   /**< interests sent again after a timeout */
+    unsigned last_use;
+} rtt_entry_t;
+
+/**
+ * @brief       Find the entry of a name, a new one is set up if needed.
+ *
+ * @param[in] comp      name components
+ * @param[in] ncomp     number of name components
+ */
+rtt_entry_t *rtt_lookup(char **comp, int ncomp);
+
+/**
+ * @brief       Add an RTT sample, only take it from interests that were
+ *              not retransmitted (Karn's algorithm).
+ */
+void rtt_sample(rtt_entry_t *e, uint32_t rtt);
+
+/**
+ * @brief       Count retransmissions of an interest.
+ */
+void rtt_retransmit(rtt_entry_t *e, unsigned count);
+
+/**
+ * @brief       Timeout for the @p retries retransmission of an interest.
+ */
+uint32_t rtt_timeout(uint32_t rto, unsigned retries);
+
+/**
+ * @brief       Get entry @p i for printing, NULL if unused.
+ */
+const rtt_entry_t *rtt_get(unsigned i);
+
+#endif /* __RTT_H */
@@ -19,23 +19,58 @@
  */
 
 #include <stdio.h>
-#include <math.h>
 
 #include "thread.h"
+#include "msg.h"
+#ifdef BOARD_NATIVE
+#include <stdlib.h>
+#include "trace.h"
+#else
 #include "smb380-board.h"
+#endif
 #include "vtimer.h"
 #include "kernel.h"
 #include "board.h"
 
 #include "sense.h"
+#include "detect.h"
+#include "stream.h"
 #include "evt_handler.h"
 
 
 #define THREAD_PRIO         (10U)
 
-#define AXIS_THRESHOLD      (230)
+/* the sampling period is adapted between these bounds, see adapt_rate() */
 #define SAMPLING_PERIOD     (50000U)
-#define REP_LIMIT           (3U)
+#define SAMPLING_PERIOD_MIN (10000U)
+#define SAMPLING_PERIOD_MAX (200000U)
+#define SAMPLING_STEP       (10000U)
+#define RATE_NEAR_MARGIN    (20)
+
+/* sleep on the SMB380 any-motion interrupt instead of polling while at rest */
+#ifdef BOARD_NATIVE
+#define WAKE_ON_MOTION      (0)
+#else
+#define WAKE_ON_MOTION      (1)
+#endif
+#define MOTION_LIMIT_MG     (100U)
+#define MOTION_QUIET_DELTA  (8)
+#define MOTION_QUIET_LIMIT  (20U)
+
+/* read all three axes in a single SSP transaction */
+#ifdef BOARD_NATIVE
+#define BURST_READ          (0)
+#else
+#define BURST_READ          (1)
+#endif
+
+/* samples are processed in batches of SAMPLE_BATCH, the FIFO size has to
+ * be a power of two */
+#define SAMPLE_FIFO_SIZE    (8U)
+#define SAMPLE_BATCH        (4U)
+
+#define MSG_MOTION          (0x5301)
+#define MSG_QUEUE_SIZE      (4)
 
 #define STATE_NORMAL        (0U)
 #define STATE_DOWN1         (2U)
@@ -47,60 +82,227 @@ long long stack[STACKSIZE];
 static int sensepid;
 
 
-static int16_t acc_data[6];
-static int state = -1;
-static int rep_count = 0;
+typedef struct {
+    int16_t acc[3];
+} sample_t;
+
+static sample_t fifo[SAMPLE_FIFO_SIZE];
+static unsigned fifo_head = 0;
+static unsigned fifo_tail = 0;
+
+static volatile uint32_t sampling_period = SAMPLING_PERIOD;
+static detect_t detector;
+
+#ifdef BOARD_NATIVE
+/* replayed instead of reading the (missing) SMB380, see trace.h */
+static trace_t trace;
+#endif
+
+#if WAKE_ON_MOTION
+static msg_t msg_q[MSG_QUEUE_SIZE];
+static unsigned quiet_count = 0;
+#endif
+static int16_t last_acc[3];
 
 
 void check_state(void);
-int math_modulus(int16_t *v, int dim);
 
 extern void _transceiver_send_handler(char *pkt);
 
 
 
+#if WAKE_ON_MOTION
+/* called from the SMB380 interrupt handler, wake-ups that arrive while the
+ * thread is polling are left in the queue and discarded before it sleeps */
+static uint8_t motion_handler(int16_t *data)
+{
+    (void) data;
+
+    msg_t m;
+    m.type = MSG_MOTION;
+    msg_send_int(&m, sensepid);
+    return 0;
+}
+#endif
+
+/* returns 1 if the current sample barely differs from the previous one */
+static int is_quiet(const int16_t *acc)
+{
+    int quiet = 1;
+
+    for (int i = 0; i < 3; i++) {
+        int16_t delta = acc[i] - last_acc[i];
+        if (delta > MOTION_QUIET_DELTA || delta < -MOTION_QUIET_DELTA) {
+            quiet = 0;
+        }
+        last_acc[i] = acc[i];
+    }
+    return quiet;
+}
+
+#if BURST_READ
+/* convert the 10 bit two's complement value spread over LSB and MSB */
+static int16_t acc_decode(uint16_t lsb, uint16_t msb)
+{
+    int16_t v = (int16_t)(((msb & 0xFF) << 2) | ((lsb & 0xC0) >> 6));
+
+    if (v & 0x200) {
+        v -= 0x400;
+    }
+    return v;
+}
+#endif
+
+/* returns 0 if no sample could be read */
+static int read_sample(sample_t *s)
+{
+#ifdef BOARD_NATIVE
+    trace_sample_t ts;
+
+    if (!trace_read(&trace, &ts)) {
+        trace_rewind(&trace);
+        if (!trace_read(&trace, &ts)) {
+            return 0;
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        s->acc[i] = ts.acc[i];
+    }
+#elif BURST_READ
+    uint16_t raw[6];
+
+    if (!SMB380_Prepare()) {
+        return 0;
+    }
+    /* X LSB, X MSB, ..., Z MSB are consecutive registers */
+    for (int i = 0; i < 6; i++) {
+        SMB380_ssp_write(SMB380_ACC_X_LSB_ADDR + i, 0, 1);
+    }
+    for (int i = 0; i < 6; i++) {
+        raw[i] = SMB380_ssp_read();
+    }
+    SMB380_Unprepare();
+
+    for (int i = 0; i < 3; i++) {
+        s->acc[i] = acc_decode(raw[2 * i], raw[2 * i + 1]);
+    }
+#else
+    int16_t mg;
+
+    SMB380_getAcceleration(SMB380_X_AXIS, &s->acc[SMB380_X_AXIS], &mg);
+    SMB380_getAcceleration(SMB380_Y_AXIS, &s->acc[SMB380_Y_AXIS], &mg);
+    SMB380_getAcceleration(SMB380_Z_AXIS, &s->acc[SMB380_Z_AXIS], &mg);
+#endif
+    return 1;
+}
+
+/* sample faster while something is about to trigger, slow down otherwise */
+static void adapt_rate(const int16_t *acc, int quiet)
+{
+    int busy = 0;
+    int rep_count = detect_rep_count(&detector);
+
+    for (int i = 0; i < 3; i++) {
+        int16_t mag = (acc[i] < 0) ? -acc[i] : acc[i];
+        if (mag > AXIS_THRESHOLD - RATE_NEAR_MARGIN &&
+            mag < AXIS_THRESHOLD + RATE_NEAR_MARGIN) {
+            busy = 1;
+        }
+    }
+    if (rep_count > 0 && rep_count < DETECT_REP_LIMIT) {
+        busy = 1;
+    }
+
+    if (busy) {
+        sampling_period /= 2;
+        if (sampling_period < SAMPLING_PERIOD_MIN) {
+            sampling_period = SAMPLING_PERIOD_MIN;
+        }
+    }
+    else if (quiet) {
+        sampling_period += SAMPLING_STEP;
+        if (sampling_period > SAMPLING_PERIOD_MAX) {
+            sampling_period = SAMPLING_PERIOD_MAX;
+        }
+    }
+}
+
+uint32_t sense_get_period(void)
+{
+    return sampling_period;
+}
+
+static unsigned fifo_count(void)
+{
+    return fifo_head - fifo_tail;
+}
+
 void *sensethread(void *unused)
 {
     (void) unused;
 
-    timex_t delay = timex_set(0, SAMPLING_PERIOD);
+#if WAKE_ON_MOTION
+    msg_init_queue(msg_q, MSG_QUEUE_SIZE);
+#endif
     for (;;) {
-        SMB380_getAcceleration(SMB380_X_AXIS, &acc_data[SMB380_X_AXIS], &acc_data[SMB380_X_AXIS + 3]);
-        SMB380_getAcceleration(SMB380_Y_AXIS, &acc_data[SMB380_Y_AXIS], &acc_data[SMB380_Y_AXIS + 3]);
-        SMB380_getAcceleration(SMB380_Z_AXIS, &acc_data[SMB380_Z_AXIS], &acc_data[SMB380_Z_AXIS + 3]);
-        check_state();
-        vtimer_sleep(delay);
+#if WAKE_ON_MOTION
+        /* nothing left to classify: wait for the sensor to report motion,
+         * unless the samples are streamed */
+        if (quiet_count >= MOTION_QUIET_LIMIT && !stream_enabled()) {
+            msg_t m;
+            check_state();
+            /* drop stale wake-ups, then re-arm the interrupt: motion from
+             * here on is reported again, at worst as one extra wake-up */
+            while (msg_try_receive(&m) == 1) {
+            }
+            SMB380_resetInterruptFlags();
+            msg_receive(&m);
+            quiet_count = 0;
+            /* a new episode starts, take its first samples at the fastest rate */
+            sampling_period = SAMPLING_PERIOD_MIN;
+        }
+#endif
+        sample_t *sample = &fifo[fifo_head & (SAMPLE_FIFO_SIZE - 1)];
+        if (!read_sample(sample)) {
+            /* the sensor was busy, try again next period */
+            vtimer_usleep(sampling_period);
+            continue;
+        }
+        ++fifo_head;
+        stream_push(sample->acc);
+        int quiet = is_quiet(sample->acc);
+#if WAKE_ON_MOTION
+        if (quiet) {
+            ++quiet_count;
+        }
+        else {
+            quiet_count = 0;
+        }
+#endif
+        if (fifo_count() >= SAMPLE_BATCH) {
+            check_state();
+        }
+        if (stream_enabled()) {
+            /* keep the stream at the full rate */
+            sampling_period = SAMPLING_PERIOD_MIN;
+        }
+        else {
+            adapt_rate(sample->acc, quiet);
+        }
+        vtimer_usleep(sampling_period);
     }
     return NULL;
 }
 
+/* process all samples that are waiting in the FIFO */
 void check_state(void)
 {
-    int norm = math_modulus(acc_data, 3);
-    // printf("--- norm: %d, x: %d, y: %d, z: %d ---\n", norm, acc_data[0], acc_data[1], acc_data[2]);
-
-    if (norm > 235 && norm < 275) {
-        // puts("NORM OK");
-        for (int i = 0; i < 3; i++) {
-            if (acc_data[i] > AXIS_THRESHOLD || acc_data[i] < -AXIS_THRESHOLD) {
-                // printf("axis %d;  %d > %d", i, acc_data[i], AXIS_THRESHOLD);
-                if (state == i) {
-                    if (rep_count < REP_LIMIT) {
-                        ++rep_count;
-                    }
-                    // printf("inc %i\n", i);
-                } else {
-                    state = i;
-                    rep_count = 0;
-                    // printf("new dir: %i\n", i);
-                }
-            }
-        }
-    }
-    
-    if (rep_count == REP_LIMIT) {
-        rep_count = REP_LIMIT + 1;
-        switch (state) {
+    while (fifo_count() > 0) {
+        sample_t *sample = &fifo[fifo_tail & (SAMPLE_FIFO_SIZE - 1)];
+        int axis = detect_sample(&detector, sample->acc);
+        ++fifo_tail;
+
+        switch (axis) {
             case STATE_NORMAL:
                 evt_handler_ok();
                 break;
@@ -117,21 +319,33 @@ void check_state(void)
 
 void sense_init(void)
 {
+    detect_reset(&detector);
+
+#ifdef BOARD_NATIVE
+    const char *path = getenv("SENSE_TRACE");
+    if (path == NULL || trace_open(&trace, path) < 0) {
+        puts("No trace to replay, set SENSE_TRACE.");
+    }
+    else if (trace.period) {
+        sampling_period = trace.period;
+    }
+#elif WAKE_ON_MOTION
     // initialize the SMB380 acceleration sensor
+    SMB380_init(motion_handler);
+    SMB380_disableNewDataInt();
+    SMB380_setSampleRate(100);
+    SMB380_setBandWidth(SMB380_BAND_WIDTH_375HZ);
+    SMB380_setRange(SMB380_RANGE_2G);
+    SMB380_setAnyMotionLimit(MOTION_LIMIT_MG, 0);
+    SMB380_enableAnyMotionLimit();
+    puts("SMB380 initialized.");
+#else
     SMB380_init_simple(100, SMB380_BAND_WIDTH_375HZ, SMB380_RANGE_2G);
     puts("SMB380 initialized.");
+#endif
 
     // setup and start sense thread
     sensepid = thread_create(stack, sizeof(stack), THREAD_PRIO, CREATE_STACKTEST, sensethread, NULL, "sense");
     puts("Sense thread created.");
 }
 
-
-int math_modulus(int16_t *v, int dim)
-{
-    float mod = 0.0f;
-    for (int i = 0; i < dim; i++) {
-        mod += powf(v[i], 2.0f);
-    }
-    return (int)sqrtf(mod);
-}
@@ -21,9 +21,18 @@
 #ifndef __SENSE_H
 #define __SENSE_H
 
+#include <stdint.h>
+
 /**
  * @brief       Start a sensor thread and start detecting events.
  */
 void sense_init(void);
 
+/**
+ * @brief       Sampling period currently used by the sensor thread.
+ *
+ * @return      period in microseconds
+ */
+uint32_t sense_get_period(void);
+
 #endif /* __SENSE_H */
\ No newline at end of file
@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup     cebit_sensor
+ * @{
+ *
+ * @file        stream.c
+ * @brief       CeBIT 2014 demo application - sensor data streaming
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "msg.h"
+#include "thread.h"
+#include "kernel.h"
+
+#include "ccn_lite/ccnl-riot.h"
+#include "ccn_lite/util/ccnl-riot-client.h"
+
+#include "stream.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+/* number of chunks kept in the ring, has to be a power of two */
+#define STREAM_RING_CHUNKS  (8U)
+#define STREAM_RING_SIZE    (STREAM_RING_CHUNKS * STREAM_CHUNK_SAMPLES)
+#define STREAM_MAX_PENDING  (4)
+#define STREAM_PRIO         (PRIORITY_MAIN - 1)
+#define STREAM_MSG_QUEUE    (8)
+#define STREAM_CHUNK_LEN    (4 + 6 * STREAM_CHUNK_SAMPLES)
+/* replies handed to the relay and possibly not consumed yet, enough for all
+ * pending chunks and the one asked for by the interest at hand */
+#define STREAM_REPLIES      (STREAM_MAX_PENDING + 1)
+
+#define MSG_STREAM_CHUNK    (0x5302)
+
+/* ccnb encoding, see the CCNx binary XML spec */
+#define CCN_TT_DTAG         (2)
+#define CCN_TT_BLOB         (5)
+#define CCN_DTAG_NAME       (14)
+#define CCN_DTAG_COMPONENT  (15)
+#define CCN_DTAG_INTEREST   (26)
+
+/* /riot/sensor/<node>/<seq> */
+#define NAME_COMP_NODE      (2)
+#define NAME_COMP_SEQ       (3)
+#define NAME_BUF_LEN        (64)
+
+char stream_stack[KERNEL_CONF_STACKSIZE_MAIN];
+static int stream_pid;
+static msg_t stream_msg_q[STREAM_MSG_QUEUE];
+static int stream_relay_pid;
+static char node_str[8];
+
+static int16_t ring[STREAM_RING_SIZE][3];
+static volatile uint32_t written = 0;
+static volatile int recording = 0;
+
+/* chunks that were asked for before they were complete */
+static uint32_t pending[STREAM_MAX_PENDING];
+static unsigned pending_count = 0;
+static volatile uint32_t wanted = UINT32_MAX;
+
+static stream_stats_t stats;
+
+typedef struct {
+    riot_ccnl_msg_t rmsg;
+    unsigned char pkt[PAYLOAD_SIZE];
+    int busy;
+} stream_reply_t;
+
+static unsigned char chunk_buf[STREAM_CHUNK_LEN];
+
+/*
+ * msg_send() returns as soon as the message is in the relay's queue, so
+ * every reply of a burst from serve_pending() gets its own buffer. A buffer
+ * stays taken until the relay is seen waiting for a message: its queue is
+ * empty then, so it is done with every reply it was sent.
+ */
+static stream_reply_t replies[STREAM_REPLIES];
+
+/* returns NULL if the relay still holds all buffers */
+static stream_reply_t *reply_get(void)
+{
+    if (thread_getstatus(stream_relay_pid) == STATUS_RECEIVE_BLOCKED) {
+        for (unsigned i = 0; i < STREAM_REPLIES; i++) {
+            replies[i].busy = 0;
+        }
+    }
+    for (unsigned i = 0; i < STREAM_REPLIES; i++) {
+        if (!replies[i].busy) {
+            replies[i].busy = 1;
+            return &replies[i];
+        }
+    }
+    return NULL;
+}
+
+void stream_push(const int16_t *acc)
+{
+    if (!recording) {
+        return;
+    }
+
+    int16_t *slot = ring[written % STREAM_RING_SIZE];
+    slot[0] = acc[0];
+    slot[1] = acc[1];
+    slot[2] = acc[2];
+    ++written;
+
+    /* wake up the server if somebody is waiting for this chunk */
+    if (written == (wanted + 1) * STREAM_CHUNK_SAMPLES) {
+        msg_t m;
+        m.type = MSG_STREAM_CHUNK;
+        msg_try_send(&m, stream_pid);
+    }
+}
+
+void stream_enable(int enable)
+{
+    recording = enable;
+}
+
+int stream_enabled(void)
+{
+    return recording;
+}
+
+void stream_stats(stream_stats_t *s)
+{
+    *s = stats;
+    s->samples = written;
+}
+
+static int ccnb_dehead(unsigned char **buf, int *len, int *num, int *typ)
+{
+    int val = 0;
+
+    if (*len > 0 && **buf == 0) {
+        /* end of element */
+        *num = *typ = 0;
+        *buf += 1;
+        *len -= 1;
+        return 0;
+    }
+    for (int i = 0; i < (int) sizeof(val) && i < *len; i++) {
+        unsigned char c = (*buf)[i];
+        if (c & 0x80) {
+            *num = (val << 4) | ((c >> 3) & 0xf);
+            *typ = c & 0x7;
+            *buf += i + 1;
+            *len -= i + 1;
+            return 0;
+        }
+        val = (val << 7) | c;
+    }
+    return -1;
+}
+
+/* split the name of an interest into NULL terminated components */
+static int interest_name(unsigned char *data, int len, char **comp, char *buf)
+{
+    int num, typ, n = 0, used = 0;
+
+    if (ccnb_dehead(&data, &len, &num, &typ) || typ != CCN_TT_DTAG || num != CCN_DTAG_INTEREST) {
+        return -1;
+    }
+    if (ccnb_dehead(&data, &len, &num, &typ) || typ != CCN_TT_DTAG || num != CCN_DTAG_NAME) {
+        return -1;
+    }
+    while (n < CCNL_MAX_NAME_COMP - 1) {
+        if (ccnb_dehead(&data, &len, &num, &typ)) {
+            return -1;
+        }
+        if (typ == 0 && num == 0) {
+            break;
+        }
+        if (typ != CCN_TT_DTAG || num != CCN_DTAG_COMPONENT) {
+            return -1;
+        }
+        if (ccnb_dehead(&data, &len, &num, &typ) || typ != CCN_TT_BLOB ||
+            num > len || used + num + 1 > NAME_BUF_LEN) {
+            return -1;
+        }
+        comp[n++] = &buf[used];
+        memcpy(&buf[used], data, num);
+        used += num;
+        buf[used++] = '\0';
+        data += num;
+        len -= num;
+        /* closing tag of the component */
+        if (ccnb_dehead(&data, &len, &num, &typ)) {
+            return -1;
+        }
+    }
+    comp[n] = NULL;
+    return n;
+}
+
+static void put_u16(unsigned char *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xff;
+}
+
+/* returns 0 if the chunk was sent, 1 if it is not complete yet and -1 if
+ * it has already been overwritten or no reply buffer is free */
+static int serve_chunk(uint32_t seq)
+{
+    uint32_t first = seq * STREAM_CHUNK_SAMPLES;
+    uint32_t end = first + STREAM_CHUNK_SAMPLES;
+
+    if (written < end) {
+        return 1;
+    }
+
+    put_u16(chunk_buf, first >> 16);
+    put_u16(chunk_buf + 2, first & 0xffff);
+    for (unsigned i = 0; i < STREAM_CHUNK_SAMPLES; i++) {
+        int16_t *slot = ring[(first + i) % STREAM_RING_SIZE];
+        for (int j = 0; j < 3; j++) {
+            put_u16(chunk_buf + 4 + 6 * i + 2 * j, (uint16_t) slot[j]);
+        }
+    }
+    /* the sensor thread may have overtaken us while copying */
+    if (written - first > STREAM_RING_SIZE) {
+        stats.expired++;
+        return -1;
+    }
+
+    char riot[] = "riot";
+    char sensor[] = "sensor";
+    char seq_str[12];
+    char *prefix[] = { riot, sensor, node_str, seq_str, NULL };
+    snprintf(seq_str, sizeof(seq_str), "%lu", (unsigned long) seq);
+
+    stream_reply_t *reply = reply_get();
+    if (reply == NULL) {
+        /* the consumer asks again once its interest times out */
+        stats.busy++;
+        return -1;
+    }
+
+    int len = mkContent(prefix, (char *) chunk_buf, sizeof(chunk_buf), reply->pkt);
+
+    msg_t m;
+    reply->rmsg.payload = reply->pkt;
+    reply->rmsg.size = len;
+    m.type = CCNL_RIOT_MSG;
+    m.content.ptr = (char *) &reply->rmsg;
+    msg_send(&m, stream_relay_pid);
+
+    stats.served++;
+    return 0;
+}
+
+static void handle_interest(riot_ccnl_msg_t *rmsg)
+{
+    char *comp[CCNL_MAX_NAME_COMP];
+    char buf[NAME_BUF_LEN];
+
+    int n = interest_name(rmsg->payload, rmsg->size, comp, buf);
+    if (n <= NAME_COMP_SEQ || strcmp(comp[NAME_COMP_NODE], node_str) != 0) {
+        DEBUG("stream: ignoring interest\n");
+        return;
+    }
+
+    uint32_t seq = strtoul(comp[NAME_COMP_SEQ], NULL, 10);
+    if (serve_chunk(seq) == 1 && pending_count < STREAM_MAX_PENDING) {
+        pending[pending_count++] = seq;
+        if (seq < wanted) {
+            wanted = seq;
+        }
+    }
+}
+
+static void serve_pending(void)
+{
+    uint32_t next = UINT32_MAX;
+    unsigned i = 0;
+
+    while (i < pending_count) {
+        int ret = serve_chunk(pending[i]);
+        if (ret != 1) {
+            /* served or given up on, serve_chunk() counted either */
+            if (ret == 0) {
+                stats.deferred++;
+            }
+            pending[i] = pending[--pending_count];
+            continue;
+        }
+        if (pending[i] < next) {
+            next = pending[i];
+        }
+        i++;
+    }
+    wanted = next;
+}
+
+static void *stream_server(void *arg)
+{
+    (void) arg;
+    msg_t m;
+
+    char prefix[NAME_BUF_LEN];
+    char faceid[10];
+    unsigned char reply[PAYLOAD_SIZE];
+
+    msg_init_queue(stream_msg_q, STREAM_MSG_QUEUE);
+    snprintf(prefix, sizeof(prefix), "/riot/sensor/%s/", node_str);
+    snprintf(faceid, sizeof(faceid), "%d", thread_getpid());
+    ccnl_riot_client_publish(stream_relay_pid, prefix, faceid, "newMSGface", reply);
+
+    for (;;) {
+        msg_receive(&m);
+        switch (m.type) {
+            case CCNL_RIOT_MSG:
+                handle_interest((riot_ccnl_msg_t *) m.content.ptr);
+                ccnl_free(m.content.ptr);
+                break;
+            case MSG_STREAM_CHUNK:
+                serve_pending();
+                break;
+            default:
+                DEBUG("stream: unexpected msg type %u\n", m.type);
+                break;
+        }
+    }
+    return NULL;
+}
+
+void stream_init(int relay_pid, uint16_t node)
+{
+    if (stream_pid) {
+        /* already running */
+        return;
+    }
+
+    stream_relay_pid = relay_pid;
+    snprintf(node_str, sizeof(node_str), "%u", node);
+    stream_pid = thread_create(stream_stack, sizeof(stream_stack), STREAM_PRIO,
+                               CREATE_STACKTEST, stream_server, NULL, "stream");
+}
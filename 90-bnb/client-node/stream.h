@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup     cebit_sensor
+ * @{
+ *
+ * @file        stream.h
+ * @brief       CeBIT 2014 demo application - sensor data streaming
+ *
+ * While streaming is enabled, the most recent samples are kept in a ring
+ * and served as named content chunks /riot/sensor/<node>/<seq>, where
+ * chunk <seq> holds samples <seq> * STREAM_CHUNK_SAMPLES and following.
+ * A chunk consists of the 32 bit number of its first sample followed by
+ * STREAM_CHUNK_SAMPLES times X, Y and Z as 16 bit values, all in network
+ * byte order. Chunks never change once written, so relays can cache them.
+ *
+ * @}
+ */
+
+#ifndef __STREAM_H
+#define __STREAM_H
+
+#include <stdint.h>
+
+#include "ccn_lite/ccnl-riot.h"
+
+#define STREAM_CHUNK_SAMPLES    ((CCNL_RIOT_CHUNK_SIZE - 1 - 4) / 6)
+
+/**
+ * @brief       Counters of the stream server
+ */
+typedef struct {
+    uint32_t samples;       /**< samples written to the ring */
+    unsigned served;        /**< chunks sent to the relay */
+    unsigned deferred;      /**< interests answered once the chunk was full */
+    unsigned expired;       /**< interests for chunks no longer in the ring */
+    unsigned busy;          /**< chunks not sent as the relay held all buffers */
+} stream_stats_t;
+
+/**
+ * @brief       Start the stream server and register its prefix.
+ *
+ * @param[in] relay_pid     thread id of the ccn-lite relay
+ * @param[in] node          node id used in the content names
+ */
+void stream_init(int relay_pid, uint16_t node);
+
+/**
+ * @brief       Enable or disable recording of samples.
+ */
+void stream_enable(int enable);
+
+/**
+ * @brief       Returns 1 if samples are recorded.
+ */
+int stream_enabled(void);
+
+/**
+ * @brief       Record one sample, called by the sensor thread.
+ */
+void stream_push(const int16_t *acc);
+
+/**
+ * @brief       Get the counters of the stream server.
+ */
+void stream_stats(stream_stats_t *stats);
+
+#endif /* __STREAM_H */
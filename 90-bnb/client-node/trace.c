@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup     cebit_sensor
+ * @{
+ *
+ * @file        trace.c
+ * @brief       CeBIT 2014 demo application - recorded accelerometer traces
+ *
+ * @}
+ */
+
+#ifdef BOARD_NATIVE
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "trace.h"
+
+#define LINE_LEN            (80)
+
+int trace_open(trace_t *trace, const char *path)
+{
+    char line[LINE_LEN];
+    unsigned long period;
+
+    trace->fp = fopen(path, "r");
+    trace->period = 0;
+    if (trace->fp == NULL) {
+        return -1;
+    }
+
+    /* the period is needed before the first sample, look for it in the
+     * comments at the top and start reading samples where they end */
+    long pos = ftell(trace->fp);
+    while (fgets(line, sizeof(line), trace->fp) != NULL && line[0] == '#') {
+        if (sscanf(line, "# period %lu", &period) == 1) {
+            trace->period = period;
+        }
+        pos = ftell(trace->fp);
+    }
+    fseek(trace->fp, pos, SEEK_SET);
+    return 0;
+}
+
+void trace_close(trace_t *trace)
+{
+    if (trace->fp != NULL) {
+        fclose(trace->fp);
+        trace->fp = NULL;
+    }
+}
+
+int trace_read(trace_t *trace, trace_sample_t *sample)
+{
+    char line[LINE_LEN];
+
+    if (trace->fp == NULL) {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), trace->fp) != NULL) {
+        int x, y, z, label;
+
+        if (line[0] == '#') {
+            continue;
+        }
+
+        switch (sscanf(line, "%d %d %d %d", &x, &y, &z, &label)) {
+            case 3:
+                label = TRACE_NO_LABEL;
+                /* fall through */
+            case 4:
+                sample->acc[0] = x;
+                sample->acc[1] = y;
+                sample->acc[2] = z;
+                sample->label = label;
+                return 1;
+            default:
+                /* skip empty or malformed lines */
+                break;
+        }
+    }
+    return 0;
+}
+
+void trace_rewind(trace_t *trace)
+{
+    if (trace->fp != NULL) {
+        rewind(trace->fp);
+    }
+}
+
+#endif /* BOARD_NATIVE */
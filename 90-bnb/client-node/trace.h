@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup     cebit_sensor
+ * @{
+ *
+ * @file        trace.h
+ * @brief       CeBIT 2014 demo application - recorded accelerometer traces
+ *
+ * Traces are plain text files, one sample per line:
+ *
+ *      <x> <y> <z> [<axis>]
+ *
+ * with the acceleration in raw SMB380 counts. The optional last column is
+ * the ground truth, i.e. the axis the detection is expected to report for
+ * this sample, or -1 while the board is moving. Lines starting with '#' are
+ * comments, a "# period <us>" comment among the ones at the top sets the
+ * sampling period the trace was recorded with.
+ *
+ * Only used on the native board, where no SMB380 is available.
+ *
+ * @}
+ */
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define TRACE_NO_LABEL      (-1)
+
+typedef struct {
+    int16_t acc[3];
+    int label;
+} trace_sample_t;
+
+typedef struct {
+    FILE *fp;
+    uint32_t period;
+} trace_t;
+
+/**
+ * @brief       Open a trace file.
+ *
+ * @return      0 on success, -1 if the file could not be opened
+ */
+int trace_open(trace_t *trace, const char *path);
+
+/**
+ * @brief       Close a trace file.
+ */
+void trace_close(trace_t *trace);
+
+/**
+ * @brief       Read the next sample from a trace.
+ *
+ * @return      1 if a sample was read, 0 at the end of the trace
+ */
+int trace_read(trace_t *trace, trace_sample_t *sample);
+
+/**
+ * @brief       Start over at the beginning of the trace.
+ */
+void trace_rewind(trace_t *trace);
+
+#endif /* __TRACE_H */
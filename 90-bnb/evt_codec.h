@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2014 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup     examples
+ * @{
+ *
+ * @file        evt_codec.h
+ * @brief       Binary wire format of cmd_t events, shared by the sensor
+ *              nodes, the router and the UDP server
+ *
+ * @}
+ */
+
+#ifndef __EVT_CODEC_H
+#define __EVT_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "events.h"
+
+/*
+ * Binary encoding of one or more cmd_t in a single frame:
+ *
+ *   header:  1 byte, EVT_CODEC_MAGIC | number of events (1..15)
+ *            2 bytes, epoch of the sender, big endian
+ *   event:   4 bytes each, dst | id | data | sequ
+ *
+ * The first byte of a frame is never ASCII, so frames can be told apart
+ * from plain ASCII text on the same UDP port. It can be the lead byte of a
+ * three byte UTF-8 sequence though: such text is taken for a frame if its
+ * length happens to match the number of events in that byte.
+ *
+ * A sender picks a new epoch every time it starts, see evt_epoch(), and
+ * puts it into all of its frames. Receivers tell from it that the sequence
+ * numbers of the sender started over, however the frames were reordered.
+ */
+#define EVT_CODEC_MAGIC         (0xE0)
+#define EVT_CODEC_MAGIC_MASK    (0xF0)
+#define EVT_CODEC_MAX_BATCH     (15)
+#define EVT_CODEC_HDR_LEN       (3)
+#define EVT_CODEC_REC_LEN       (4)
+#define EVT_CODEC_FRAME_LEN(n)  (EVT_CODEC_HDR_LEN + (n) * EVT_CODEC_REC_LEN)
+#define EVT_CODEC_MAX_FRAME     EVT_CODEC_FRAME_LEN(EVT_CODEC_MAX_BATCH)
+
+/* returns 1 if buf holds a well-formed frame */
+static inline int evt_is_frame(const uint8_t *buf, size_t len)
+{
+    if (len < EVT_CODEC_HDR_LEN) {
+        return 0;
+    }
+    if ((buf[0] & EVT_CODEC_MAGIC_MASK) != EVT_CODEC_MAGIC) {
+        return 0;
+    }
+    unsigned n = buf[0] & ~EVT_CODEC_MAGIC_MASK;
+    return (n > 0 && len == EVT_CODEC_FRAME_LEN(n));
+}
+
+/* epoch for a sender that just started, from anything that differs from
+ * start to start, e.g. the time of its first frame in us. Never 0, so that
+ * receivers can use 0 for no epoch. Two starts get the same epoch with a
+ * chance of 1 in 65535. */
+static inline uint16_t evt_epoch(uint32_t entropy)
+{
+    uint16_t epoch = (uint16_t)(entropy ^ (entropy >> 16));
+
+    return epoch ? epoch : 1;
+}
+
+/* returns the length of the frame or -1 if it does not fit into buf */
+static inline int evt_encode(const cmd_t *cmds, unsigned n, uint16_t epoch,
+                             uint8_t *buf, size_t len)
+{
+    if (n == 0 || n > EVT_CODEC_MAX_BATCH || len < EVT_CODEC_FRAME_LEN(n)) {
+        return -1;
+    }
+
+    buf[0] = EVT_CODEC_MAGIC | n;
+    buf[1] = epoch >> 8;
+    buf[2] = epoch & 0xff;
+    for (unsigned i = 0; i < n; i++) {
+        uint8_t *rec = &buf[EVT_CODEC_FRAME_LEN(i)];
+        rec[0] = cmds[i].dst;
+        rec[1] = (uint8_t) cmds[i].id;
+        rec[2] = (uint8_t) cmds[i].data;
+        rec[3] = cmds[i].sequ;
+    }
+    return EVT_CODEC_FRAME_LEN(n);
+}
+
+/* returns the number of events decoded or -1 for a malformed frame, the
+ * epoch of the sender goes to *epoch */
+static inline int evt_decode(const uint8_t *buf, size_t len, uint16_t *epoch,
+                             cmd_t *cmds, unsigned max)
+{
+    if (!evt_is_frame(buf, len)) {
+        return -1;
+    }
+
+    unsigned n = buf[0] & ~EVT_CODEC_MAGIC_MASK;
+    if (n > max) {
+        return -1;
+    }
+    *epoch = (buf[1] << 8) | buf[2];
+    for (unsigned i = 0; i < n; i++) {
+        const uint8_t *rec = &buf[EVT_CODEC_FRAME_LEN(i)];
+        cmds[i].dst = rec[0];
+        cmds[i].id = (evt_t) rec[1];
+        cmds[i].data = (char) rec[2];
+        cmds[i].sequ = rec[3];
+    }
+    return n;
+}
+
+/* hex representation of a frame, for use as a CCN name component */
+static inline int evt_to_hex(const uint8_t *buf, size_t len, char *out, size_t outlen)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    if (outlen < 2 * len + 1) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        out[2 * i] = digits[buf[i] >> 4];
+        out[2 * i + 1] = digits[buf[i] & 0xf];
+    }
+    out[2 * len] = '\0';
+    return 2 * len;
+}
+
+static inline int evt_hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/* returns the number of bytes written to buf or -1 */
+static inline int evt_from_hex(const char *hex, uint8_t *buf, size_t len)
+{
+    size_t n = 0;
+
+    while (hex[0] && hex[1]) {
+        int hi = evt_hex_digit(hex[0]);
+        int lo = evt_hex_digit(hex[1]);
+        if (hi < 0 || lo < 0 || n >= len) {
+            return -1;
+        }
+        buf[n++] = (hi << 4) | lo;
+        hex += 2;
+    }
+    return hex[0] ? -1 : (int) n;
+}
+
+#endif /* __EVT_CODEC_H */
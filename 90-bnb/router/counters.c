@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Traffic counters of the router application
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "irq.h"
+#include "vtimer.h"
+
+#include "cstore.h"
+#include "counters.h"
+
+static const char *cnt_key[CNT_NUMOF] = { "req", "io", "ci", "ans", "udp", "drop", "pool", "to", "agg" };
+
+static uint32_t count[CNT_NUMOF];
+static uint32_t pending;
+static timex_t since;
+
+void counters_init(void)
+{
+    vtimer_now(&since);
+}
+
+void counters_add(cnt_t cnt, uint32_t n)
+{
+    unsigned irq_state = disableIRQ();
+    count[cnt] += n;
+    restoreIRQ(irq_state);
+}
+
+void counters_pending(int delta)
+{
+    unsigned irq_state = disableIRQ();
+    pending += delta;
+    restoreIRQ(irq_state);
+}
+
+void counters_snapshot(counters_t *snap, int reset)
+{
+    cstore_stats_t cs;
+    timex_t now;
+
+    cstore_stats(&cs, reset);
+    vtimer_now(&now);
+
+    unsigned irq_state = disableIRQ();
+    memcpy(snap->count, count, sizeof(count));
+    snap->pending = pending;
+    if (reset) {
+        memset(count, 0, sizeof(count));
+    }
+    restoreIRQ(irq_state);
+
+    snap->ms = timex_uint64(timex_sub(now, since)) / 1000;
+    if (reset) {
+        since = now;
+    }
+
+    snap->cs_entries = cs.entries;
+    snap->cs_bytes = cs.bytes;
+    snap->cs_hits = cs.hits;
+    snap->cs_misses = cs.misses;
+    snap->cs_evictions = cs.evictions;
+}
+
+void counters_print(const counters_t *snap)
+{
+    printf("cnt,%" PRIu32, snap->ms);
+    for (int i = 0; i < CNT_NUMOF; i++) {
+        printf(",%s=%" PRIu32, cnt_key[i], snap->count[i]);
+    }
+    printf(",pend=%" PRIu32 ",gwc=%" PRIu32 ",gwcb=%" PRIu32 ",gwhit=%" PRIu32
+           ",gwmiss=%" PRIu32 ",gwev=%" PRIu32 "\n",
+           snap->pending, snap->cs_entries, snap->cs_bytes, snap->cs_hits,
+           snap->cs_misses, snap->cs_evictions);
+}
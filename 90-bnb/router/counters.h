@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Traffic counters of the router application
+ *
+ * Counts what the application's own code handles: the requests of the
+ * gateway (gateway.h) and the datagrams of the UDP server. These are not
+ * the counters of the relay. Interests that client nodes send to the relay
+ * never pass this code, and the relay, which is part of RIOT's ccn_lite
+ * module and not of this tree, keeps its counters to itself. Only `stat`
+ * prints them, as text. A snapshot also holds the state of the gateway's
+ * cache and is printed as a single line of key=value pairs:
+ *
+ *      cnt,<ms since the last reset>,req=<gateway requests>,io=<interests to the relay>,...
+ *
+ * @}
+ */
+
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <stdint.h>
+
+typedef enum {
+    CNT_INTEREST_IN,        /**< requests for content the gateway got */
+    CNT_INTEREST_OUT,       /**< interests the gateway sent to the relay */
+    CNT_CONTENT_IN,         /**< content the relay returned to the gateway */
+    CNT_CONTENT_OUT,        /**< gateway requests answered */
+    CNT_UDP_IN,             /**< datagrams received */
+    CNT_DROP,               /**< datagrams and requests given up on */
+    CNT_POOL_EMPTY,         /**< datagrams that found no free buffer */
+    CNT_TIMEOUT,            /**< gateway interests the relay got no content for */
+    CNT_AGGREGATED,         /**< gateway requests that joined a pending one */
+    CNT_NUMOF
+} cnt_t;
+
+typedef struct {
+    uint32_t ms;            /**< since the counters were reset */
+    uint32_t count[CNT_NUMOF];
+    uint32_t pending;       /**< gateway interests the relay did not answer yet */
+    uint32_t cs_entries;    /**< of the gateway's cache, as the ones below */
+    uint32_t cs_bytes;
+    uint32_t cs_hits;
+    uint32_t cs_misses;
+    uint32_t cs_evictions;
+} counters_t;
+
+void counters_init(void);
+
+void counters_add(cnt_t cnt, uint32_t n);
+
+#define counters_inc(cnt) counters_add((cnt), 1)
+
+/**
+ * @brief interests in flight to the relay, up on send and down on answer
+ */
+void counters_pending(int delta);
+
+/**
+ * @brief take a snapshot
+ *
+ * @param[in] reset     start counting from zero, the gateway cache's
+ *                      counters included
+ */
+void counters_snapshot(counters_t *snap, int reset);
+
+void counters_print(const counters_t *snap);
+
+#endif /* COUNTERS_H */
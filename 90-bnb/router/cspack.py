@@ -0,0 +1,104 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# Copyright (C) 2014 INRIA
+#
+# This file is subject to the terms and conditions of the GNU Lesser General
+# Public License. See the file LICENSE in the top level directory for more
+# details.
+
+"""Pack content into an image for the router's gateway cache, see preload.h.
+
+Content is given as name=file pairs, or as a directory whose files are
+stored under a prefix:
+
+    cspack.py -o image.bin /riot/appserver/test=test.txt
+    cspack.py -c cs_image.c --prefix /riot/data --dir content/
+
+An image written to cs_image.c in the router's directory is compiled in and
+loaded at boot. A binary image can be loaded on native with `preload <file>`.
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b"CSI1"
+MAX_NAME = 255
+MAX_DATA = 0xffff
+
+
+def read(path):
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def pack(entries):
+    image = bytearray(MAGIC)
+    image += struct.pack("<HH", len(entries), 0)
+    for name, freshness, data in entries:
+        name = name.encode("ascii")
+        image += struct.pack("<BHH", len(name), freshness, len(data))
+        image += name
+        image += data
+    return image
+
+
+def to_c(image):
+    lines = ["/* generated by cspack.py, do not edit */", "",
+             "#include <stddef.h>", "#include <stdint.h>", "",
+             "const uint8_t cs_image[] = {"]
+    for i in range(0, len(image), 12):
+        lines.append("    " + " ".join("0x%02x," % b for b in image[i:i + 12]))
+    lines += ["};", "", "const size_t cs_image_len = sizeof(cs_image);", ""]
+    return "\n".join(lines)
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("content", nargs="*", metavar="name=file")
+    p.add_argument("-o", "--output", help="binary image to write")
+    p.add_argument("-c", "--c-source", help="C source to write, e.g. cs_image.c")
+    p.add_argument("-f", "--freshness", type=int, default=0,
+                   help="lifetime in seconds, 0 (the default) for content "
+                        "that never goes stale")
+    p.add_argument("--dir", help="directory to pack")
+    p.add_argument("--prefix", default="", help="name prefix for --dir")
+    args = p.parse_args()
+
+    if not args.output and not args.c_source:
+        p.error("give -o and/or -c")
+
+    entries = []
+    for arg in args.content:
+        name, sep, path = arg.partition("=")
+        if not sep:
+            p.error("expected name=file, got '%s'" % arg)
+        entries.append((name, args.freshness, read(path)))
+    if args.dir:
+        for f in sorted(os.listdir(args.dir)):
+            path = os.path.join(args.dir, f)
+            if os.path.isfile(path):
+                entries.append((args.prefix.rstrip("/") + "/" + f, args.freshness, read(path)))
+
+    for name, _, data in entries:
+        if len(name) > MAX_NAME or len(data) > MAX_DATA:
+            p.error("%s: name or content too long" % name)
+
+    image = pack(entries)
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(image)
+    if args.c_source:
+        with open(args.c_source, "w") as f:
+            f.write(to_c(image))
+
+    print("%d entries, %d bytes" % (len(entries), len(image)), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
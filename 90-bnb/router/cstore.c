@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Byte budgeted cache of the gateway
+ *
+ * @}
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mutex.h"
+#include "vtimer.h"
+
+#include "cstore.h"
+
+typedef struct {
+    uint32_t hash;
+    uint16_t off;           /* of the name in the arena, the data follows */
+    uint16_t len;
+    uint8_t name_len;
+    uint16_t hits;
+    uint32_t used;          /* tick of the last access */
+    uint32_t expires;       /* in seconds, UINT32_MAX for never */
+} cs_entry_t;
+
+static char arena[CSTORE_ARENA_SIZE];
+/* ordered by offset, the arena is kept without gaps */
+static cs_entry_t entry[CSTORE_MAX_ENTRIES];
+static unsigned entries;
+static size_t bytes;
+static uint32_t tick;
+
+static size_t budget = CSTORE_ARENA_SIZE;
+static cstore_policy_t policy = CSTORE_LRU;
+static unsigned freshness = CSTORE_FRESHNESS;
+
+static cstore_stats_t stats;
+static mutex_t lock;
+
+static const char *policy_str[] = { "lru", "lfu", "fresh" };
+
+static uint32_t cs_now(void)
+{
+    timex_t now;
+
+    vtimer_now(&now);
+    return now.tv_sec;
+}
+
+static uint32_t cs_hash(const char *name, size_t len)
+{
+    uint32_t h = 5381;
+
+    while (len--) {
+        h = (h << 5) + h + (uint8_t) *name++;
+    }
+    return h;
+}
+
+static int cs_find(const char *name, size_t name_len, uint32_t hash)
+{
+    for (unsigned i = 0; i < entries; i++) {
+        cs_entry_t *e = &entry[i];
+        if (e->hash == hash && e->name_len == name_len
+            && memcmp(arena + e->off, name, name_len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void cs_remove(unsigned i)
+{
+    size_t size = entry[i].name_len + entry[i].len;
+    size_t end = entry[i].off + size;
+
+    memmove(arena + entry[i].off, arena + end, bytes - end);
+    bytes -= size;
+
+    for (unsigned j = i + 1; j < entries; j++) {
+        entry[j].off -= size;
+        entry[j - 1] = entry[j];
+    }
+    entries--;
+}
+
+static unsigned cs_victim(void)
+{
+    uint32_t now = cs_now();
+    unsigned v = 0;
+
+    for (unsigned i = 1; i < entries; i++) {
+        cs_entry_t *e = &entry[i];
+        cs_entry_t *best = &entry[v];
+
+        switch (policy) {
+            case CSTORE_LFU:
+                if (e->hits < best->hits
+                    || (e->hits == best->hits && e->used < best->used)) {
+                    v = i;
+                }
+                break;
+
+            case CSTORE_FRESH:
+                /* a stale entry is as good as any other stale one */
+                if (best->expires > now && e->expires < best->expires) {
+                    v = i;
+                }
+                break;
+
+            default:
+                if (e->used < best->used) {
+                    v = i;
+                }
+                break;
+        }
+    }
+    return v;
+}
+
+static void cs_evict(size_t limit, unsigned max_entries)
+{
+    while (entries && (bytes > limit || entries > max_entries)) {
+        cs_remove(cs_victim());
+        stats.evictions++;
+    }
+}
+
+void cstore_init(void)
+{
+    mutex_init(&lock);
+}
+
+int cstore_config(size_t new_budget, cstore_policy_t new_policy, unsigned new_freshness)
+{
+    if (new_budget > CSTORE_ARENA_SIZE) {
+        return -1;
+    }
+
+    mutex_lock(&lock);
+    budget = new_budget;
+    policy = new_policy;
+    freshness = new_freshness;
+    cs_evict(budget, CSTORE_MAX_ENTRIES);
+    mutex_unlock(&lock);
+    return 0;
+}
+
+int cstore_put(const char *name, const char *data, size_t len, uint32_t lifetime)
+{
+    size_t name_len = strlen(name);
+    size_t size = name_len + len;
+    uint32_t hash = cs_hash(name, name_len);
+
+    mutex_lock(&lock);
+
+    if (name_len > UINT8_MAX || size > budget) {
+        stats.rejected++;
+        mutex_unlock(&lock);
+        return -1;
+    }
+
+    int i = cs_find(name, name_len, hash);
+    if (i >= 0) {
+        cs_remove(i);
+    }
+    cs_evict(budget - size, CSTORE_MAX_ENTRIES - 1);
+
+    cs_entry_t *e = &entry[entries++];
+    e->hash = hash;
+    e->off = bytes;
+    e->len = len;
+    e->name_len = name_len;
+    e->hits = 0;
+    e->used = ++tick;
+    if (lifetime == CSTORE_FOREVER) {
+        e->expires = UINT32_MAX;
+    }
+    else {
+        e->expires = cs_now() + (lifetime ? lifetime : freshness);
+    }
+    memcpy(arena + bytes, name, name_len);
+    memcpy(arena + bytes + name_len, data, len);
+    bytes += size;
+    stats.inserts++;
+
+    mutex_unlock(&lock);
+    return 0;
+}
+
+int cstore_get(const char *name, char *buf, size_t size)
+{
+    size_t name_len = strlen(name);
+    int len = -1;
+
+    mutex_lock(&lock);
+
+    int i = cs_find(name, name_len, cs_hash(name, name_len));
+    if (i < 0) {
+        stats.misses++;
+    }
+    else if (entry[i].expires <= cs_now()) {
+        cs_remove(i);
+        stats.stale++;
+        stats.misses++;
+    }
+    else if (entry[i].len <= size) {
+        cs_entry_t *e = &entry[i];
+        memcpy(buf, arena + e->off + e->name_len, e->len);
+        len = e->len;
+        if (e->hits < UINT16_MAX) {
+            e->hits++;
+        }
+        e->used = ++tick;
+        stats.hits++;
+    }
+
+    mutex_unlock(&lock);
+    return len;
+}
+
+void cstore_stats(cstore_stats_t *out, int reset)
+{
+    mutex_lock(&lock);
+    stats.entries = entries;
+    stats.bytes = bytes;
+    stats.budget = budget;
+    stats.policy = policy;
+    stats.freshness = freshness;
+    *out = stats;
+    if (reset) {
+        memset(&stats, 0, sizeof(stats));
+    }
+    mutex_unlock(&lock);
+}
+
+const char *cstore_policy_str(cstore_policy_t p)
+{
+    return policy_str[p];
+}
+
+int cstore_policy_parse(const char *str, cstore_policy_t *p)
+{
+    for (unsigned i = 0; i < sizeof(policy_str) / sizeof(policy_str[0]); i++) {
+        if (strcmp(str, policy_str[i]) == 0) {
+            *p = (cstore_policy_t) i;
+            return 0;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Byte budgeted cache of the gateway
+ *
+ * Holds content for the requests the gateway answers (see gateway.h), in
+ * front of the relay. It is not the content store of the relay: that one
+ * is part of the ccn_lite module in RIOT, it is sized in entries with
+ * `config <max_cache_entries>` and its policy cannot be changed from here.
+ *
+ * Content is kept back to back in a static arena, so an entry costs its name
+ * and its data and nothing is lost to fragmentation. The budget can be set
+ * to anything up to CSTORE_ARENA_SIZE at runtime. When a new entry does not
+ * fit, entries are evicted according to the replacement policy:
+ *
+ *  - LRU:   the least recently used entry
+ *  - LFU:   the entry with the fewest hits, the least recently used of them
+ *           on a tie
+ *  - FRESH: a stale entry, or else the one that goes stale first
+ *
+ * Stale entries are never served, whatever the policy.
+ *
+ * @}
+ */
+
+#ifndef CSTORE_H
+#define CSTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef CSTORE_ARENA_SIZE
+#define CSTORE_ARENA_SIZE       (4096)
+#endif
+#define CSTORE_MAX_ENTRIES      (32)
+#define CSTORE_FRESHNESS        (10)    /**< default lifetime in seconds */
+#define CSTORE_FOREVER          (UINT32_MAX)    /**< lifetime that never ends */
+
+typedef enum {
+    CSTORE_LRU,
+    CSTORE_LFU,
+    CSTORE_FRESH
+} cstore_policy_t;
+
+typedef struct {
+    unsigned entries;
+    size_t bytes;               /**< name and data of all entries */
+    size_t budget;
+    cstore_policy_t policy;
+    unsigned freshness;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t stale;             /**< lookups that found a stale entry */
+    uint32_t inserts;
+    uint32_t evictions;
+    uint32_t rejected;          /**< content larger than the budget */
+} cstore_stats_t;
+
+void cstore_init(void);
+
+/**
+ * @brief set budget, policy and the lifetime of new entries
+ *
+ * Entries are evicted right away if the store is over the new budget.
+ *
+ * @return 0 on success, -1 if the budget exceeds CSTORE_ARENA_SIZE
+ */
+int cstore_config(size_t budget, cstore_policy_t policy, unsigned freshness);
+
+/**
+ * @brief store content under a name, replacing older content of that name
+ *
+ * @param[in] freshness     lifetime in seconds, 0 for the configured one,
+ *                          CSTORE_FOREVER for content that never goes stale
+ *
+ * @return 0 on success, -1 if it cannot fit into the budget
+ */
+int cstore_put(const char *name, const char *data, size_t len, uint32_t freshness);
+
+/**
+ * @brief copy the content of a name into a buffer
+ *
+ * @return length of the content, -1 on a miss or if @p size is too small
+ */
+int cstore_get(const char *name, char *buf, size_t size);
+
+/**
+ * @brief get the counters
+ *
+ * @param[in] reset     clear hits, misses and the other event counters
+ */
+void cstore_stats(cstore_stats_t *stats, int reset);
+
+const char *cstore_policy_str(cstore_policy_t policy);
+
+/**
+ * @brief parse "lru", "lfu" or "fresh"
+ *
+ * @return 0 on success, -1 on an unknown policy
+ */
+int cstore_policy_parse(const char *str, cstore_policy_t *policy);
+
+#endif /* CSTORE_H */
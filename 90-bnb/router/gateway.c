@@ -0,0 +1,580 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief UDP to CCN gateway of the router
+ *
+ * @}
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "thread.h"
+#include "msg.h"
+#include "irq.h"
+#include "vtimer.h"
+#include "random.h"
+
+#include "socket_base/socket.h"
+
+#include "net_help.h"
+
+#include "ccn_lite/ccnl-riot.h"
+
+#include "cstore.h"
+#include "counters.h"
+#include "gateway.h"
+#include "prefetch.h"
+#include "qos.h"
+
+/* requests waiting for the worker, a power of two */
+#define GATEWAY_JOBS        (4)
+/* requesters answered by one fetch */
+#define GATEWAY_WAITERS     (8)
+#define GATEWAY_NAME_LEN    (64)
+#define GATEWAY_REPLY_SIZE  (128)
+
+typedef struct {
+    int used;
+    int started;            /* taken by the worker */
+    int due;                /* window over, see gw_next() */
+    int done;               /* being answered, no one can join any more */
+    int prefetch;           /* the content goes into the cache, see prefetch.h */
+    unsigned lifetime;      /* of the prefetched content in s */
+    unsigned seq;           /* order of arrival */
+    qos_class_t cls;        /* highest class of the waiters */
+    char name[GATEWAY_NAME_LEN];
+    timex_t start;
+    unsigned waiters;
+    sockaddr6_t sa[GATEWAY_WAITERS];
+    qos_class_t wcls[GATEWAY_WAITERS];
+    timex_t arrived[GATEWAY_WAITERS];
+} gw_pending_t;
+
+typedef struct {
+    int pid;
+    int alarm;              /* serves alarms only, else all other classes */
+    /* set when a request was opened or an alarm joined one, the worker's
+     * queue only takes replies of the relay */
+    volatile int kick;
+    qos_wrr_t wrr;
+    /* the worker fetches no more than fits into an answer */
+    char buf[GATEWAY_REPLY_SIZE - 1];
+} gw_worker_t;
+
+char gateway_stack_buffer[KERNEL_CONF_STACKSIZE_MAIN];
+char gateway_worker_stack_buffer[KERNEL_CONF_STACKSIZE_MAIN];
+char gateway_alarm_stack_buffer[KERNEL_CONF_STACKSIZE_MAIN];
+
+extern int relay_pid;
+
+static int sock = -1;
+/* alarms have a worker of their own, so that they never wait for the
+ * chunks of a bulk fetch */
+static gw_worker_t worker;
+static gw_worker_t alarm_worker = { .alarm = 1 };
+
+static gw_pending_t pending[GATEWAY_JOBS];
+static unsigned seq;
+
+static uint32_t window = GATEWAY_WINDOW;
+static gateway_stats_t stats;
+
+/* content answered from the cache */
+static char gw_buf[GATEWAY_CONTENT_SIZE];
+
+/*
+ * Join the pending request for a name, or open a new one if there is none
+ * with room left. Returns NULL if all are taken, sets opened if the worker
+ * has to be told about the request.
+ *
+ * A class can open as many requests as its queue limit, and the last free
+ * one is kept for alarms.
+ */
+static gw_pending_t *gw_join(const char *name, sockaddr6_t *sa, qos_class_t cls,
+                             timex_t arrived, int *opened)
+{
+    gw_pending_t *p = NULL, *unused = NULL;
+    qos_class_cfg_t cfg;
+    unsigned unused_n = 0, in_class = 0;
+
+    qos_get_class(cls, &cfg);
+
+    unsigned irq_state = disableIRQ();
+    for (int i = 0; i < GATEWAY_JOBS; i++) {
+        gw_pending_t *q = &pending[i];
+        if (!q->used) {
+            unused_n++;
+            if (!unused) {
+                unused = q;
+            }
+        }
+        else if (!q->done && q->waiters < GATEWAY_WAITERS && strcmp(q->name, name) == 0) {
+            p = q;
+            break;
+        }
+        else if (q->cls == cls) {
+            in_class++;
+        }
+    }
+
+    if (p) {
+        p->sa[p->waiters] = *sa;
+        p->wcls[p->waiters] = cls;
+        p->arrived[p->waiters++] = arrived;
+        if (cls < p->cls) {
+            p->cls = cls;
+        }
+        stats.aggregated++;
+        *opened = 0;
+    }
+    else if (unused && in_class < cfg.limit && (cls == QOS_ALARM || unused_n > 1)) {
+        p = unused;
+        p->used = 1;
+        p->started = 0;
+        p->due = 0;
+        p->done = 0;
+        p->seq = seq++;
+        p->cls = cls;
+        strcpy(p->name, name);
+        p->start = arrived;
+        p->prefetch = 0;
+        p->waiters = 1;
+        p->sa[0] = *sa;
+        p->wcls[0] = cls;
+        p->arrived[0] = arrived;
+        *opened = 1;
+    }
+    restoreIRQ(irq_state);
+
+    if (p && !*opened) {
+        counters_inc(CNT_AGGREGATED);
+    }
+    return p;
+}
+
+/*
+ * The oldest request of the class the worker is to serve next, among those
+ * whose window is over. A request is held back for the window, so that
+ * requests for the same name can join it, unless it is or was joined by an
+ * alarm. If none is due, wait is set to the time in us until the first one
+ * is, or to 0 if there is none.
+ */
+static gw_pending_t *gw_next(gw_worker_t *w, uint32_t *wait)
+{
+    unsigned backlog[QOS_CLASSES] = { 0 };
+    gw_pending_t *p = NULL;
+    timex_t now;
+
+    *wait = 0;
+    vtimer_now(&now);
+
+    unsigned irq_state = disableIRQ();
+    for (int i = 0; i < GATEWAY_JOBS; i++) {
+        gw_pending_t *q = &pending[i];
+        if (!q->used || q->started || (q->cls == QOS_ALARM) != w->alarm) {
+            continue;
+        }
+        uint32_t waited = timex_uint64(timex_sub(now, q->start));
+        if (q->cls == QOS_ALARM || waited >= window) {
+            q->due = 1;
+            backlog[q->cls]++;
+        }
+        else {
+            q->due = 0;
+            if (!*wait || window - waited < *wait) {
+                *wait = window - waited;
+            }
+        }
+    }
+
+    int c = qos_pick(&w->wrr, backlog);
+    for (int i = 0; c >= 0 && i < GATEWAY_JOBS; i++) {
+        gw_pending_t *q = &pending[i];
+        if (q->used && !q->started && q->due && (int) q->cls == c &&
+            (!p || (int) (q->seq - p->seq) < 0)) {
+            p = q;
+        }
+    }
+    if (p) {
+        p->started = 1;
+    }
+    restoreIRQ(irq_state);
+    return p;
+}
+
+static void gw_reply(sockaddr6_t *sa, uint8_t status, const char *data, int len)
+{
+    uint8_t frame[GATEWAY_REPLY_SIZE];
+
+    if (len > GATEWAY_REPLY_SIZE - 1) {
+        len = GATEWAY_REPLY_SIZE - 1;
+        status = GATEWAY_PARTIAL;
+    }
+    frame[0] = status;
+    if (len) {
+        memcpy(frame + 1, data, len);
+    }
+
+    if (socket_base_sendto(sock, frame, len + 1, 0, sa, sizeof(*sa)) < 0) {
+        counters_inc(CNT_DROP);
+    }
+}
+
+/* send the interest for one chunk, returns the chunk or NULL on a NACK */
+static riot_ccnl_msg_t *gw_get_chunk(char **comp)
+{
+    unsigned char interest[PAYLOAD_SIZE];
+    unsigned int nonce = genrand_uint32();
+    riot_ccnl_msg_t rmsg;
+    msg_t m;
+
+    rmsg.payload = interest;
+    rmsg.size = mkInterest(comp, &nonce, interest);
+    m.type = CCNL_RIOT_MSG;
+    m.content.ptr = (char *) &rmsg;
+    msg_send(&m, relay_pid);
+
+    do {
+        msg_receive(&m);
+    } while (m.type != CCNL_RIOT_MSG && m.type != CCNL_RIOT_NACK);
+
+    return (m.type == CCNL_RIOT_MSG) ? (riot_ccnl_msg_t *) m.content.ptr : NULL;
+}
+
+/*
+ * Fetch content over CCN chunk by chunk, like ccnl_riot_client_get() does,
+ * but no more than size bytes of it. Sets more if the content goes on.
+ * Returns the length, 0 if the content could not be fetched.
+ *
+ * The content is not kept, the relay has it in its content store already.
+ */
+static int gw_fetch_ccn(const char *name, char *buf, size_t size, int *more)
+{
+    char request[GATEWAY_NAME_LEN];
+    char chunk[12];
+    char *comp[CCNL_MAX_NAME_COMP];
+    int n = 0;
+    size_t len = 0;
+
+    strncpy(request, name, sizeof(request) - 1);
+    request[sizeof(request) - 1] = '\0';
+    for (char *c = strtok(request, "/"); c; c = strtok(NULL, "/")) {
+        /* room for the chunk number and the end of the list */
+        if (n == CCNL_MAX_NAME_COMP - 2) {
+            return 0;
+        }
+        comp[n++] = c;
+    }
+    comp[n] = chunk;
+    comp[n + 1] = NULL;
+
+    *more = 0;
+    counters_inc(CNT_INTEREST_OUT);
+    counters_pending(1);
+    for (unsigned seg = 0; len < size; seg++) {
+        snprintf(chunk, sizeof(chunk), "%u", seg);
+        riot_ccnl_msg_t *reply = gw_get_chunk(comp);
+        if (!reply) {
+            len = 0;
+            break;
+        }
+
+        size_t part = reply->size;
+        /* the last chunk is the first one that is not full */
+        int last = (reply->size < CCNL_RIOT_CHUNK_SIZE - 1);
+        if (part > size - len) {
+            part = size - len;
+            last = 0;
+        }
+        memcpy(buf + len, reply->payload, part);
+        len += part;
+        ccnl_free(reply);
+
+        if (last) {
+            break;
+        }
+        if (len == size) {
+            *more = 1;
+        }
+    }
+    counters_pending(-1);
+
+    if (!len) {
+        counters_inc(CNT_TIMEOUT);
+        return 0;
+    }
+    counters_inc(CNT_CONTENT_IN);
+    return len;
+}
+
+int gateway_fetch(const char *name, char *buf, int *cached)
+{
+    int more;
+
+    counters_inc(CNT_INTEREST_IN);
+
+    int len = cstore_get(name, buf, GATEWAY_CONTENT_SIZE);
+    prefetch_lookup(name, len >= 0);
+    if (cached) {
+        *cached = (len >= 0);
+    }
+    if (len < 0) {
+        len = gw_fetch_ccn(name, buf, GATEWAY_CONTENT_SIZE, &more);
+    }
+    if (len > 0) {
+        counters_inc(CNT_CONTENT_OUT);
+    }
+    return len;
+}
+
+/* wake the worker of a class up to pick the next request */
+static void gw_kick(qos_class_t cls)
+{
+    gw_worker_t *w = (cls == QOS_ALARM) ? &alarm_worker : &worker;
+
+    w->kick = 1;
+    thread_wakeup(w->pid);
+}
+
+static void *gateway_worker(void *arg)
+{
+    gw_worker_t *w = arg;
+    vtimer_t timer;
+    uint32_t wait;
+    int more;
+
+    while (1) {
+        /* whatever comes in from here on is seen by gw_next() or wakes
+         * the worker up again */
+        w->kick = 0;
+        gw_pending_t *p = gw_next(w, &wait);
+        if (!p) {
+            /* sleep until a request is opened, an alarm joins one or the
+             * first window is over, requests are served by class then */
+            if (wait) {
+                vtimer_set_wakeup(&timer, timex_set(0, wait), w->pid);
+            }
+            unsigned irq_state = disableIRQ();
+            if (!w->kick) {
+                thread_sleep();
+            }
+            restoreIRQ(irq_state);
+            if (wait) {
+                vtimer_remove(&timer);
+            }
+            continue;
+        }
+
+        int len = gw_fetch_ccn(p->name, w->buf, sizeof(w->buf), &more);
+
+        unsigned irq_state = disableIRQ();
+        p->done = 1;
+        restoreIRQ(irq_state);
+
+        if (p->prefetch) {
+            /* only content that is complete is worth keeping */
+            prefetch_done(p->name, len > 0 && !more &&
+                          cstore_put(p->name, w->buf, len, p->lifetime) == 0);
+        }
+
+        for (unsigned i = 0; i < p->waiters; i++) {
+            if (len > 0) {
+                counters_inc(CNT_CONTENT_OUT);
+                gw_reply(&p->sa[i], more ? GATEWAY_PARTIAL : GATEWAY_OK, w->buf, len);
+            }
+            else {
+                gw_reply(&p->sa[i], GATEWAY_NOT_FOUND, NULL, 0);
+            }
+            qos_sent(p->wcls[i], p->arrived[i]);
+        }
+
+        irq_state = disableIRQ();
+        if (p->waiters) {
+            stats.fetches++;
+        }
+        if (p->prefetch) {
+            stats.prefetches++;
+        }
+        stats.answered += p->waiters;
+        p->used = 0;
+        restoreIRQ(irq_state);
+    }
+
+    return NULL;
+}
+
+static void *gateway_thread(void *arg)
+{
+    (void) arg;
+
+    sockaddr6_t sa;
+    uint32_t fromlen;
+    char name[GATEWAY_NAME_LEN];
+    timex_t arrived;
+
+    sock = socket_base_socket(PF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sin6_family = AF_INET;
+    sa.sin6_port = HTONS(GATEWAY_PORT);
+
+    if (-1 == socket_base_bind(sock, &sa, sizeof(sa))) {
+        printf("Error bind failed!\n");
+        socket_base_close(sock);
+        return NULL;
+    }
+
+    while (1) {
+        fromlen = sizeof(sa);
+        int32_t recsize = socket_base_recvfrom(sock, name, sizeof(name) - 1, 0,
+                                               &sa, &fromlen);
+        if (recsize <= 0) {
+            continue;
+        }
+        vtimer_now(&arrived);
+        counters_inc(CNT_UDP_IN);
+        name[recsize] = '\0';
+
+        if (name[0] != '/') {
+            gw_reply(&sa, GATEWAY_BAD_REQUEST, NULL, 0);
+            continue;
+        }
+        counters_inc(CNT_INTEREST_IN);
+
+        qos_class_t cls = qos_class_port(NTOHS(sa.sin6_port),
+                                         qos_class_name(name, QOS_NORMAL));
+
+        int len = cstore_get(name, gw_buf, sizeof(gw_buf));
+        prefetch_lookup(name, len >= 0);
+        if (len >= 0) {
+            counters_inc(CNT_CONTENT_OUT);
+            gw_reply(&sa, GATEWAY_OK, gw_buf, len);
+            qos_queued(cls);
+            qos_sent(cls, arrived);
+            continue;
+        }
+
+        int opened;
+        gw_pending_t *p = gw_join(name, &sa, cls, arrived, &opened);
+        if (!p) {
+            counters_inc(CNT_DROP);
+            qos_dropped(cls);
+            gw_reply(&sa, GATEWAY_BUSY, NULL, 0);
+            continue;
+        }
+        qos_queued(cls);
+
+        if (opened || cls == QOS_ALARM) {
+            /* the worker picks the request to serve by class, a request
+             * an alarm joined is the alarm worker's from now on */
+            gw_kick(cls);
+        }
+    }
+
+    return NULL;
+}
+
+int gateway_prefetch(const char *name, unsigned lifetime)
+{
+    gw_pending_t *p = NULL, *unused = NULL;
+    qos_class_cfg_t cfg;
+    unsigned unused_n = 0, in_class = 0;
+    timex_t now;
+    int opened = 0;
+
+    if (strlen(name) >= GATEWAY_NAME_LEN) {
+        return -1;
+    }
+    qos_get_class(QOS_BULK, &cfg);
+    vtimer_now(&now);
+
+    unsigned irq_state = disableIRQ();
+    for (int i = 0; i < GATEWAY_JOBS; i++) {
+        gw_pending_t *q = &pending[i];
+        if (!q->used) {
+            unused_n++;
+            if (!unused) {
+                unused = q;
+            }
+        }
+        else if (!q->done && strcmp(q->name, name) == 0) {
+            p = q;
+            break;
+        }
+        else if (q->cls == QOS_BULK) {
+            in_class++;
+        }
+    }
+
+    if (!p && unused && in_class < cfg.limit && unused_n > 1) {
+        p = unused;
+        p->used = 1;
+        p->started = 0;
+        p->due = 0;
+        p->done = 0;
+        p->seq = seq++;
+        p->cls = QOS_BULK;
+        strcpy(p->name, name);
+        p->start = now;
+        p->waiters = 0;
+        opened = 1;
+    }
+    if (p) {
+        p->prefetch = 1;
+        p->lifetime = lifetime;
+    }
+    restoreIRQ(irq_state);
+
+    if (opened) {
+        gw_kick(QOS_BULK);
+    }
+    return p ? 0 : -1;
+}
+
+void gateway_window(uint32_t us)
+{
+    window = us;
+}
+
+void gateway_stats(gateway_stats_t *out, int reset)
+{
+    unsigned irq_state = disableIRQ();
+    stats.window = window;
+    *out = stats;
+    if (reset) {
+        memset(&stats, 0, sizeof(stats));
+    }
+    restoreIRQ(irq_state);
+}
+
+void gateway_start(void)
+{
+    worker.pid = thread_create(
+            gateway_worker_stack_buffer, sizeof(gateway_worker_stack_buffer),
+            PRIORITY_MAIN, CREATE_STACKTEST,
+            gateway_worker, &worker, "gateway_worker");
+
+    /* above the other worker, an alarm preempts it between two chunks */
+    alarm_worker.pid = thread_create(
+            gateway_alarm_stack_buffer, sizeof(gateway_alarm_stack_buffer),
+            PRIORITY_MAIN - 1, CREATE_STACKTEST,
+            gateway_worker, &alarm_worker, "gateway_alarm");
+
+    int pid = thread_create(
+            gateway_stack_buffer, sizeof(gateway_stack_buffer),
+            PRIORITY_MAIN, CREATE_STACKTEST,
+            gateway_thread, NULL, "gateway");
+    printf("UDP/CCN GATEWAY ON PORT %d (THREAD PID: %d)\n", HTONS(GATEWAY_PORT), pid);
+}
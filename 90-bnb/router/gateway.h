@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief UDP to CCN gateway of the router
+ *
+ * A datagram to GATEWAY_PORT holding a name, e.g. /riot/appserver/test, is
+ * answered from the gateway's cache (cstore.h) if it can be, which holds
+ * preloaded content. Otherwise a worker thread fetches the content over
+ * CCN and answers then. Alarms have a worker of their own, at a higher
+ * priority, so they never wait for a bulk fetch to finish. The answer is a status byte followed by as much of
+ * the content as fits into a datagram, and the worker fetches no more
+ * chunks than that takes. Fetched content is not kept by the gateway, the
+ * relay caches it in its own content store. Only prefetched content is put
+ * into the gateway's cache.
+ *
+ * The workers are woken up with thread_wakeup(), so that their message
+ * queues only ever hold replies of the relay.
+ *
+ * Requests for a name that is already being fetched join that fetch and are
+ * answered along with it. A new fetch is held back for a short window, so
+ * that requests arriving at almost the same time, e.g. from sensor nodes
+ * that all saw the same event, make a single interest upstream. The worker
+ * serves other requests meanwhile.
+ *
+ * This only aggregates the requests of UDP clients of the gateway, and
+ * gateway_stats() only counts those. Client nodes send their interests to
+ * the relay over the transceiver, not through this code. Holding those
+ * back would take a change to the relay's PIT, which is part of RIOT's
+ * ccn_lite module and not of this tree.
+ *
+ * Requests are served by their traffic class, see qos.h. Alarms are not held
+ * back, neither is a request an alarm joined, and the last free pending
+ * request is kept for them. Interests that client nodes send to the relay
+ * directly are not classified: the relay serves its message queue in order,
+ * and changing that takes RIOT's ccn_lite module, which is not part of
+ * this tree.
+ *
+ * @}
+ */
+
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GATEWAY_PORT            (0xFF02)
+
+/**
+ * largest content gateway_fetch() returns, longer content is cut. This is
+ * the largest content used in the examples, see the 3 KB buffer of
+ * ccn-lite-client.
+ */
+#define GATEWAY_CONTENT_SIZE    (3 * 1024)
+
+/** time in us a fetch is held back for other requests to join */
+#ifndef GATEWAY_WINDOW
+#define GATEWAY_WINDOW          (20 * 1000U)
+#endif
+
+/** status byte of an answer */
+#define GATEWAY_OK              (0)
+#define GATEWAY_PARTIAL         (1)     /**< content cut to fit the datagram */
+#define GATEWAY_NOT_FOUND       (2)
+#define GATEWAY_BUSY            (3)     /**< too many requests in flight */
+#define GATEWAY_BAD_REQUEST     (4)
+
+typedef struct {
+    uint32_t window;        /**< in us */
+    uint32_t fetches;       /**< interests sent upstream for requests */
+    uint32_t answered;      /**< requests answered by these */
+    uint32_t aggregated;    /**< requests that joined a pending fetch */
+    uint32_t prefetches;    /**< fetches for the cache, see prefetch.h */
+} gateway_stats_t;
+
+/**
+ * @brief start the gateway and its worker threads
+ */
+void gateway_start(void);
+
+/**
+ * @brief get content from the gateway's cache or else over CCN
+ *
+ * @param[in]  name     name of the content
+ * @param[out] buf      at least GATEWAY_CONTENT_SIZE bytes
+ * @param[out] cached   set if the gateway's cache had it, may be NULL
+ *
+ * @return length of the content, 0 if none was found
+ */
+int gateway_fetch(const char *name, char *buf, int *cached);
+
+/**
+ * @brief fetch content into the gateway's cache, see prefetch.h
+ *
+ * The fetch is a request of class QOS_BULK without a requester, or joins
+ * the pending request for the name. prefetch_done() is called once it is
+ * over. Content longer than an answer is not kept.
+ *
+ * @param[in] lifetime  in seconds
+ *
+ * @return 0 on success, -1 if there is no room for another request
+ */
+int gateway_prefetch(const char *name, unsigned lifetime);
+
+/**
+ * @brief set the time a fetch is held back, 0 to send it right away
+ */
+void gateway_window(uint32_t us);
+
+/**
+ * @brief get the counters, answered / fetches is the aggregation ratio of
+ *        the gateway's UDP clients
+ */
+void gateway_stats(gateway_stats_t *stats, int reset);
+
+#endif /* GATEWAY_H */
@@ -30,6 +30,12 @@
 #include "ccn_lite/util/ccnl-riot-client.h"
 
 #include "demo.h"
+#include "cstore.h"
+#include "counters.h"
+#include "preload.h"
+#include "gateway.h"
+#include "prefetch.h"
+#include "qos.h"
 
 #define RIOT_CCN_APPSERVER (1)
 #define RIOT_CCN_TESTS (0)
@@ -48,7 +54,7 @@ msg_t msg_buffer_shell[SHELL_MSG_BUFFER_SIZE];
 
 shell_t shell;
 
-unsigned char big_buf[3];
+unsigned char big_buf[GATEWAY_CONTENT_SIZE + 1];
 char small_buf[PAYLOAD_SIZE];
 
 #if RIOT_CCN_APPSERVER
@@ -84,12 +90,16 @@ static void riot_ccn_express_interest(int argc, char **argv)
 
     DEBUG("in='%s'\n", small_buf);
 
-    int content_len = ccnl_riot_client_get(relay_pid, small_buf, (char *) big_buf); // small_buf=name to request
+    int cached;
+    int content_len = gateway_fetch(small_buf, (char *) big_buf, &cached);
 
     if (content_len == 0) {
         puts("riot_get returned 0 bytes...aborting!");
         return;
     }
+    if (cached) {
+        puts("served from the gateway cache");
+    }
 
     puts("####################################################");
     big_buf[content_len] = '\0';
@@ -118,6 +128,38 @@ static void riot_ccn_register_prefix(int argc, char **argv)
     puts("done");
 }
 
+static void riot_ccn_cstore_config(int argc, char **argv)
+{
+    cstore_stats_t stats;
+    cstore_policy_t policy;
+
+    cstore_stats(&stats, 0);
+    policy = stats.policy;
+
+    if (argc > 1) {
+        size_t budget = atoi(argv[1]);
+        unsigned freshness = (argc > 3) ? (unsigned) atoi(argv[3]) : stats.freshness;
+
+        if (argc > 2 && cstore_policy_parse(argv[2], &policy) < 0) {
+            printf("unknown policy '%s'\n", argv[2]);
+            return;
+        }
+        if (cstore_config(budget, policy, freshness) < 0) {
+            printf("budget exceeds %u bytes\n", CSTORE_ARENA_SIZE);
+            return;
+        }
+        cstore_stats(&stats, 0);
+    }
+
+    printf("gwcache: %u entries, %u/%u bytes, %s, fresh for %us\n",
+           stats.entries, (unsigned) stats.bytes, (unsigned) stats.budget,
+           cstore_policy_str(stats.policy), stats.freshness);
+    printf("gwcache: %" PRIu32 " hits, %" PRIu32 " misses, %" PRIu32 " stale, %" PRIu32
+           " inserts, %" PRIu32 " evictions, %" PRIu32 " rejected\n",
+           stats.hits, stats.misses, stats.stale, stats.inserts,
+           stats.evictions, stats.rejected);
+}
+
 static void riot_ccn_relay_config(int argc, char **argv)
 {
     if (!relay_pid) {
@@ -283,6 +325,26 @@ static void riot_ccn_populate(int argc, char **argv)
     msg_send(&m, relay_pid);
 }
 
+static void riot_ccn_preload(int argc, char **argv)
+{
+    preload_result_t res;
+    int ret;
+
+    if (argc > 1) {
+        ret = preload_file(argv[1], &res);
+    }
+    else {
+        ret = preload_builtin(&res);
+    }
+
+    if (ret < 0) {
+        puts("no image, or a malformed one");
+        return;
+    }
+    printf("preloaded %u of %u entries, %u bytes in %" PRIu32 " us\n",
+           res.stored, res.entries, (unsigned) res.bytes, res.us);
+}
+
 static void riot_ccn_stat(int argc, char **argv)
 {
     (void) argc; /* the function takes no arguments */
@@ -294,13 +356,151 @@ static void riot_ccn_stat(int argc, char **argv)
     msg_send(&m, relay_pid);
 }
 
+static void riot_ccn_counters(int argc, char **argv)
+{
+    counters_t snap;
+
+    /* "cnt keep" leaves the counters running */
+    counters_snapshot(&snap, !(argc > 1 && strcmp(argv[1], "keep") == 0));
+    counters_print(&snap);
+}
+
+static void riot_ccn_gateway(int argc, char **argv)
+{
+    gateway_stats_t stats;
+
+    if (argc > 1) {
+        gateway_window(atoi(argv[1]) * 1000U);
+    }
+
+    gateway_stats(&stats, 1);
+    printf("gw,window_ms=%" PRIu32 ",fetches=%" PRIu32 ",answered=%" PRIu32
+           ",agg=%" PRIu32 ",prefetches=%" PRIu32 ",ratio=%" PRIu32 ".%02" PRIu32 "\n",
+           stats.window / 1000, stats.fetches, stats.answered, stats.aggregated,
+           stats.prefetches,
+           stats.fetches ? stats.answered / stats.fetches : 0,
+           stats.fetches ? (stats.answered * 100 / stats.fetches) % 100 : 0);
+}
+
+static void riot_ccn_qos_usage(const char *cmd)
+{
+    printf("usage: %s [keep | strict | wrr | class <class> <limit> [tail|head] [<weight>] |\n"
+           "       prefix <prefix> <class> | port <port> <class>]\n", cmd);
+}
+
+static void riot_ccn_qos(int argc, char **argv)
+{
+    qos_class_cfg_t cfg;
+    qos_stats_t stats;
+    qos_class_t cls;
+
+    if (argc > 1 && strcmp(argv[1], "strict") == 0) {
+        qos_set_sched(QOS_STRICT);
+        return;
+    }
+    if (argc > 1 && strcmp(argv[1], "wrr") == 0) {
+        qos_set_sched(QOS_WEIGHTED);
+        return;
+    }
+    if (argc > 3 && strcmp(argv[1], "class") == 0) {
+        if (qos_class_parse(argv[2], &cls) < 0) {
+            riot_ccn_qos_usage(argv[0]);
+            return;
+        }
+        qos_get_class(cls, &cfg);
+        cfg.limit = atoi(argv[3]);
+        if (argc > 4) {
+            cfg.drop = (strcmp(argv[4], "head") == 0) ? QOS_DROP_HEAD : QOS_DROP_TAIL;
+        }
+        if (argc > 5) {
+            cfg.weight = atoi(argv[5]);
+        }
+        if (qos_set_class(cls, &cfg) < 0) {
+            printf("the limit is at most %d\n", QOS_QUEUE_MAX);
+        }
+        return;
+    }
+    if (argc > 3 && (strcmp(argv[1], "prefix") == 0 || strcmp(argv[1], "port") == 0)) {
+        if (qos_class_parse(argv[3], &cls) < 0) {
+            riot_ccn_qos_usage(argv[0]);
+            return;
+        }
+        int ret = (argv[1][1] == 'r') ? qos_rule_prefix(argv[2], cls)
+                                      : qos_rule_port(atoi(argv[2]), cls);
+        if (ret < 0) {
+            puts("prefix too long or no rule free");
+        }
+        return;
+    }
+    if (argc > 1 && strcmp(argv[1], "keep") != 0) {
+        riot_ccn_qos_usage(argv[0]);
+        return;
+    }
+
+    /* "qos keep" leaves the counters running */
+    for (int i = 0; i < QOS_CLASSES; i++) {
+        qos_get_class((qos_class_t) i, &cfg);
+        qos_stats((qos_class_t) i, &stats, argc == 1);
+        printf("qos,%s,%s,limit=%u,policy=%s,weight=%u,queued=%" PRIu32 ",sent=%" PRIu32
+               ",drop=%" PRIu32 ",lat_us=%" PRIu32 ",max_us=%" PRIu32 "\n",
+               qos_class_str((qos_class_t) i),
+               (qos_get_sched() == QOS_STRICT) ? "strict" : "wrr",
+               cfg.limit, (cfg.drop == QOS_DROP_HEAD) ? "head" : "tail", cfg.weight,
+               stats.queued, stats.sent, stats.dropped,
+               stats.sent ? (uint32_t) (stats.lat_sum / stats.sent) : 0, stats.lat_max);
+    }
+}
+
+static void riot_ccn_prefetch(int argc, char **argv)
+{
+    prefetch_rule_t rule;
+
+    if (argc > 2 && strcmp(argv[1], "add") == 0) {
+        unsigned lifetime = (argc > 3) ? (unsigned) atoi(argv[3]) : PREFETCH_LIFETIME;
+        if (prefetch_add(argv[2], lifetime) < 0) {
+            puts("bad name or no rule free");
+        }
+        return;
+    }
+    if (argc > 2 && strcmp(argv[1], "del") == 0) {
+        if (prefetch_del(argv[2]) < 0) {
+            printf("no rule for %s\n", argv[2]);
+        }
+        return;
+    }
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        prefetch_reset();
+        return;
+    }
+    if (argc > 1) {
+        printf("usage: %s [add <name> [<lifetime s>] | del <name> | reset]\n", argv[0]);
+        return;
+    }
+
+    for (unsigned i = 0; i < PREFETCH_RULES; i++) {
+        if (prefetch_get(i, &rule) < 0) {
+            continue;
+        }
+        printf("prefetch,%s,lifetime_s=%u,issued=%" PRIu32 ",skipped=%" PRIu32
+               ",stored=%" PRIu32 ",hits=%" PRIu32 ",misses=%" PRIu32 "\n",
+               rule.name, rule.lifetime, rule.issued, rule.skipped, rule.stored,
+               rule.hits, rule.misses);
+    }
+}
+
 static const shell_command_t sc[] = {
     { "haltccn", "stops ccn relay", riot_ccn_relay_stop },
     { "interest", "express an interest", riot_ccn_express_interest },
     { "populate", "populate the cache of the relay with data", riot_ccn_populate },
+    { "preload", "fills the gateway's cache from the built in image or a file (native)", riot_ccn_preload },
     { "prefix", "registers a prefix to a face", riot_ccn_register_prefix },
     { "stat", "prints out forwarding statistics", riot_ccn_stat },
+    { "cnt", "prints the gateway and UDP counters (not the relay's) in one line and resets them", riot_ccn_counters },
+    { "gw", "prints and resets the aggregation ratio of the gateway's UDP clients: gw [<window ms>]", riot_ccn_gateway },
+    { "qos", "prints and resets the counters per traffic class, or configures the classes", riot_ccn_qos },
     { "config", "changes the runtime config of the ccn lite relay", riot_ccn_relay_config },
+    { "gwcache", "configures the gateway's cache: gwcache [<bytes> [lru|lfu|fresh [<freshness s>]]]", riot_ccn_cstore_config },
+    { "prefetch", "content fetched into the gateway's cache on warnings: prefetch [add <name> [<lifetime s>] | del <name> | reset]", riot_ccn_prefetch },
     { "appserver", "starts an application server to reply to interests", riot_ccn_appserver },
     { "init", "Initialize network", rpl_udp_init},
     { "set", "Set ID", rpl_udp_set_id},
@@ -340,6 +540,12 @@ int main(void)
     }
     */
 
+    cstore_init();
+    prefetch_init();
+    counters_init();
+#ifdef CS_IMAGE
+    riot_ccn_preload(1, NULL);
+#endif
     riot_ccn_relay_start();
     
     /* fill neighbor cache */
@@ -349,6 +555,7 @@ int main(void)
     riot_ccn_appserver(1, NULL);
     rpl_ex_init('n');
     udp_server(1, NULL);
+    gateway_start();
 
     posix_open(uart0_handler_pid, 0);
     net_if_set_src_address_mode(0, NET_IF_TRANS_ADDR_M_SHORT);
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Content prefetched on warnings
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "mutex.h"
+
+#include "gateway.h"
+#include "prefetch.h"
+
+/* shared by the UDP server, the gateway and the shell */
+static prefetch_rule_t rules[PREFETCH_RULES];
+static mutex_t lock;
+
+static prefetch_rule_t *pf_find(const char *name)
+{
+    for (unsigned i = 0; i < PREFETCH_RULES; i++) {
+        if (rules[i].name[0] && strcmp(rules[i].name, name) == 0) {
+            return &rules[i];
+        }
+    }
+    return NULL;
+}
+
+void prefetch_init(void)
+{
+    mutex_init(&lock);
+    memset(rules, 0, sizeof(rules));
+}
+
+int prefetch_add(const char *name, unsigned lifetime)
+{
+    if (strlen(name) >= PREFETCH_NAME_LEN || name[0] != '/') {
+        return -1;
+    }
+
+    mutex_lock(&lock);
+    prefetch_rule_t *r = pf_find(name);
+    if (!r) {
+        for (unsigned i = 0; !r && i < PREFETCH_RULES; i++) {
+            if (!rules[i].name[0]) {
+                r = &rules[i];
+            }
+        }
+        if (r) {
+            memset(r, 0, sizeof(*r));
+            strcpy(r->name, name);
+        }
+    }
+    if (r) {
+        r->lifetime = lifetime;
+    }
+    mutex_unlock(&lock);
+
+    return r ? 0 : -1;
+}
+
+int prefetch_del(const char *name)
+{
+    mutex_lock(&lock);
+    prefetch_rule_t *r = pf_find(name);
+    if (r) {
+        r->name[0] = '\0';
+    }
+    mutex_unlock(&lock);
+
+    return r ? 0 : -1;
+}
+
+void prefetch_warn(void)
+{
+    mutex_lock(&lock);
+    for (unsigned i = 0; i < PREFETCH_RULES; i++) {
+        prefetch_rule_t *r = &rules[i];
+        if (!r->name[0] || r->busy) {
+            continue;
+        }
+        if (gateway_prefetch(r->name, r->lifetime) == 0) {
+            r->busy = 1;
+            r->issued++;
+        }
+        else {
+            r->skipped++;
+        }
+    }
+    mutex_unlock(&lock);
+}
+
+void prefetch_done(const char *name, int stored)
+{
+    mutex_lock(&lock);
+    prefetch_rule_t *r = pf_find(name);
+    if (r) {
+        r->busy = 0;
+        if (stored) {
+            r->stored++;
+        }
+    }
+    mutex_unlock(&lock);
+}
+
+void prefetch_lookup(const char *name, int hit)
+{
+    mutex_lock(&lock);
+    prefetch_rule_t *r = pf_find(name);
+    if (r) {
+        if (hit) {
+            r->hits++;
+        }
+        else {
+            r->misses++;
+        }
+    }
+    mutex_unlock(&lock);
+}
+
+int prefetch_get(unsigned i, prefetch_rule_t *rule)
+{
+    int ret = -1;
+
+    mutex_lock(&lock);
+    if (i < PREFETCH_RULES && rules[i].name[0]) {
+        *rule = rules[i];
+        ret = 0;
+    }
+    mutex_unlock(&lock);
+    return ret;
+}
+
+void prefetch_reset(void)
+{
+    mutex_lock(&lock);
+    for (unsigned i = 0; i < PREFETCH_RULES; i++) {
+        rules[i].issued = 0;
+        rules[i].skipped = 0;
+        rules[i].stored = 0;
+        rules[i].hits = 0;
+        rules[i].misses = 0;
+    }
+    mutex_unlock(&lock);
+}
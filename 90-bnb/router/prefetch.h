@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Content prefetched on warnings
+ *
+ * A rule names content, e.g. /riot/appserver/test, that is fetched as soon
+ * as a client node reports a WARN event to the UDP server, so that the
+ * request an ALARM makes shortly after finds it close by. The gateway
+ * fetches it like a request of class QOS_BULK without a requester (see
+ * gateway.h) and puts it into its cache (cstore.h) for the lifetime of
+ * the rule. The relay keeps a copy in its content store on the way.
+ *
+ * Only content that fits into one answer of the gateway is prefetched. A
+ * rule is not fetched again while its last prefetch is still pending.
+ *
+ * Hits and misses count the lookups of the gateway's cache for the name of
+ * a rule, so they show whether prefetching pays off. The relay's content
+ * store is part of RIOT's ccn_lite module and has no counters that could
+ * be read from here.
+ *
+ * @}
+ */
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <stdint.h>
+
+#define PREFETCH_RULES      (4)
+#define PREFETCH_NAME_LEN   (64)
+#define PREFETCH_LIFETIME   (30)    /**< default in seconds */
+
+typedef struct {
+    char name[PREFETCH_NAME_LEN];
+    unsigned lifetime;      /**< in seconds */
+    int busy;               /**< a prefetch is pending */
+    uint32_t issued;        /**< prefetches taken by the gateway */
+    uint32_t skipped;       /**< warnings the gateway had no room for */
+    uint32_t stored;        /**< prefetches that ended up in the cache */
+    uint32_t hits;          /**< lookups of the name the cache answered */
+    uint32_t misses;
+} prefetch_rule_t;
+
+void prefetch_init(void);
+
+/**
+ * @brief add a rule, replacing the lifetime of one for the same name
+ *
+ * @return 0 on success, -1 if the name is too long or all rules are taken
+ */
+int prefetch_add(const char *name, unsigned lifetime);
+
+/**
+ * @return 0 on success, -1 if there is no rule for the name
+ */
+int prefetch_del(const char *name);
+
+/**
+ * @brief have the gateway fetch the content of every rule
+ */
+void prefetch_warn(void);
+
+/**
+ * @brief called by the gateway once a prefetch is over
+ *
+ * @param[in] stored    set if the content was put into the cache
+ */
+void prefetch_done(const char *name, int stored);
+
+/**
+ * @brief count a lookup of the gateway's cache
+ */
+void prefetch_lookup(const char *name, int hit);
+
+/**
+ * @brief copy a rule
+ *
+ * @return 0 on success, -1 if the rule is not in use
+ */
+int prefetch_get(unsigned i, prefetch_rule_t *rule);
+
+/**
+ * @brief clear the counters of all rules
+ */
+void prefetch_reset(void);
+
+#endif /* PREFETCH_H */
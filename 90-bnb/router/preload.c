@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Fill the gateway's cache from a prebuilt image
+ *
+ * @}
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef BOARD_NATIVE
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "irq.h"
+#include "vtimer.h"
+
+#include "cstore.h"
+#include "preload.h"
+
+#ifdef CS_IMAGE
+/* generated by cspack.py */
+extern const uint8_t cs_image[];
+extern const size_t cs_image_len;
+#endif
+
+static unsigned get16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+int preload_image(const uint8_t *image, size_t len, preload_result_t *res)
+{
+    char name[UINT8_MAX + 1];
+    timex_t start, end;
+    size_t pos = PRELOAD_HEADER_LEN;
+
+    memset(res, 0, sizeof(*res));
+    if (len < PRELOAD_HEADER_LEN || memcmp(image, PRELOAD_MAGIC, 4) != 0) {
+        return -1;
+    }
+
+    vtimer_now(&start);
+    for (unsigned n = get16(image + 4); n; n--) {
+        if (pos + PRELOAD_ENTRY_LEN > len) {
+            return -1;
+        }
+        unsigned name_len = image[pos];
+        unsigned freshness = get16(image + pos + 1);
+        unsigned data_len = get16(image + pos + 3);
+        pos += PRELOAD_ENTRY_LEN;
+        if (pos + name_len + data_len > len) {
+            return -1;
+        }
+
+        memcpy(name, image + pos, name_len);
+        name[name_len] = '\0';
+        pos += name_len;
+
+        res->entries++;
+        if (cstore_put(name, (const char *) image + pos, data_len,
+                       freshness ? freshness : CSTORE_FOREVER) == 0) {
+            res->stored++;
+            res->bytes += name_len + data_len;
+        }
+        pos += data_len;
+    }
+    vtimer_now(&end);
+
+    res->us = timex_uint64(timex_sub(end, start));
+    return 0;
+}
+
+int preload_builtin(preload_result_t *res)
+{
+#ifdef CS_IMAGE
+    return preload_image(cs_image, cs_image_len, res);
+#else
+    (void) res;
+    return -1;
+#endif
+}
+
+int preload_file(const char *path, preload_result_t *res)
+{
+#ifdef BOARD_NATIVE
+    struct stat st;
+    void *image = MAP_FAILED;
+
+    /* keep RIOT's signals out of the host's system calls */
+    unsigned irq_state = disableIRQ();
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            image = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+    }
+    restoreIRQ(irq_state);
+
+    if (image == MAP_FAILED) {
+        return -1;
+    }
+
+    int ret = preload_image(image, st.st_size, res);
+
+    irq_state = disableIRQ();
+    munmap(image, st.st_size);
+    restoreIRQ(irq_state);
+    return ret;
+#else
+    (void) path;
+    (void) res;
+    return -1;
+#endif
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Fill the gateway's cache from a prebuilt image
+ *
+ * The entries go into the gateway's cache (cstore.h), where the gateway
+ * finds them. The relay does not see them: it drops content nobody asked
+ * for, so its content store cannot be filled from the application.
+ *
+ * Images are made on the host with cspack.py. An image written to cs_image.c
+ * in this directory is compiled in, placed in flash along with the other
+ * constant data, and loaded at boot. On native, an image file can also be
+ * mapped into memory and loaded with `preload <file>`.
+ *
+ * Layout, all numbers little endian:
+ *
+ *      "CSI1", uint16 number of entries, uint16 reserved
+ *      per entry: uint8 name length, uint16 freshness in s (0 for content
+ *                 that never goes stale), uint16 data length, name, data
+ *
+ * @}
+ */
+
+#ifndef PRELOAD_H
+#define PRELOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PRELOAD_MAGIC       "CSI1"
+#define PRELOAD_HEADER_LEN  (8)
+#define PRELOAD_ENTRY_LEN   (5)     /**< without name and data */
+
+typedef struct {
+    unsigned entries;       /**< entries in the image */
+    unsigned stored;        /**< of which the gateway's cache took */
+    size_t bytes;           /**< name and data of the stored entries */
+    uint32_t us;            /**< time it took */
+} preload_result_t;
+
+/**
+ * @brief put every entry of an image into the gateway's cache
+ *
+ * @return 0 on success, -1 if the image is malformed
+ */
+int preload_image(const uint8_t *image, size_t len, preload_result_t *res);
+
+/**
+ * @brief load the image compiled in from cs_image.c
+ *
+ * @return 0 on success, -1 if there is none or it is malformed
+ */
+int preload_builtin(preload_result_t *res);
+
+/**
+ * @brief map an image file and load it, native only
+ *
+ * @return 0 on success, -1 if the file cannot be mapped or is malformed
+ */
+int preload_file(const char *path, preload_result_t *res);
+
+#endif /* PRELOAD_H */
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Traffic classes of the router
+ *
+ * @}
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "irq.h"
+#include "vtimer.h"
+
+#include "qos.h"
+
+typedef struct {
+    int used;
+    int is_port;
+    uint16_t port;
+    char prefix[QOS_PREFIX_LEN];
+    qos_class_t cls;
+} qos_rule_t;
+
+static const char *class_str[QOS_CLASSES] = { "alarm", "normal", "bulk" };
+
+static qos_rule_t rules[QOS_RULES];
+
+static qos_sched_t sched = QOS_STRICT;
+
+/* alarms keep the latest, the others what came first */
+static qos_class_cfg_t cfg[QOS_CLASSES] = {
+    { QOS_QUEUE_MAX, QOS_DROP_HEAD, 4 },
+    { QOS_QUEUE_MAX, QOS_DROP_TAIL, 2 },
+    { 2, QOS_DROP_TAIL, 1 },
+};
+
+static qos_stats_t stats[QOS_CLASSES];
+
+static int qos_rule_add(const qos_rule_t *rule)
+{
+    qos_rule_t *unused = NULL;
+    int ret = 0;
+
+    unsigned irq_state = disableIRQ();
+    for (int i = 0; i < QOS_RULES; i++) {
+        qos_rule_t *r = &rules[i];
+        if (!r->used) {
+            if (!unused) {
+                unused = r;
+            }
+        }
+        else if (r->is_port == rule->is_port && r->port == rule->port &&
+                 strcmp(r->prefix, rule->prefix) == 0) {
+            unused = r;
+            break;
+        }
+    }
+    if (unused) {
+        *unused = *rule;
+    }
+    else {
+        ret = -1;
+    }
+    restoreIRQ(irq_state);
+    return ret;
+}
+
+int qos_rule_prefix(const char *prefix, qos_class_t cls)
+{
+    qos_rule_t r;
+
+    if (strlen(prefix) >= QOS_PREFIX_LEN) {
+        return -1;
+    }
+    memset(&r, 0, sizeof(r));
+    r.used = 1;
+    strcpy(r.prefix, prefix);
+    r.cls = cls;
+    return qos_rule_add(&r);
+}
+
+int qos_rule_port(uint16_t port, qos_class_t cls)
+{
+    qos_rule_t r;
+
+    memset(&r, 0, sizeof(r));
+    r.used = 1;
+    r.is_port = 1;
+    r.port = port;
+    r.cls = cls;
+    return qos_rule_add(&r);
+}
+
+qos_class_t qos_class_name(const char *name, qos_class_t dflt)
+{
+    qos_class_t cls = dflt;
+    size_t best = 0;
+
+    for (int i = 0; i < QOS_RULES; i++) {
+        qos_rule_t *r = &rules[i];
+        if (!r->used || r->is_port) {
+            continue;
+        }
+        size_t len = strlen(r->prefix);
+        if (len > best && strncmp(name, r->prefix, len) == 0) {
+            best = len;
+            cls = r->cls;
+        }
+    }
+    return cls;
+}
+
+qos_class_t qos_class_port(uint16_t port, qos_class_t dflt)
+{
+    for (int i = 0; i < QOS_RULES; i++) {
+        if (rules[i].used && rules[i].is_port && rules[i].port == port) {
+            return rules[i].cls;
+        }
+    }
+    return dflt;
+}
+
+void qos_set_sched(qos_sched_t s)
+{
+    sched = s;
+}
+
+qos_sched_t qos_get_sched(void)
+{
+    return sched;
+}
+
+int qos_set_class(qos_class_t cls, const qos_class_cfg_t *c)
+{
+    if (c->limit > QOS_QUEUE_MAX) {
+        return -1;
+    }
+
+    unsigned irq_state = disableIRQ();
+    cfg[cls] = *c;
+    if (!cfg[cls].weight) {
+        cfg[cls].weight = 1;
+    }
+    restoreIRQ(irq_state);
+    return 0;
+}
+
+void qos_get_class(qos_class_t cls, qos_class_cfg_t *c)
+{
+    *c = cfg[cls];
+}
+
+int qos_pick(qos_wrr_t *wrr, const unsigned backlog[QOS_CLASSES])
+{
+    int first = -1;
+
+    for (int c = 0; c < QOS_CLASSES; c++) {
+        if (backlog[c]) {
+            first = c;
+            break;
+        }
+    }
+    if (first < 0 || sched == QOS_STRICT) {
+        return first;
+    }
+
+    for (int round = 0; round < 2; round++) {
+        for (int c = first; c < QOS_CLASSES; c++) {
+            if (backlog[c] && wrr->credit[c]) {
+                wrr->credit[c]--;
+                return c;
+            }
+        }
+        /* all classes with a backlog are out of turns, start a new round */
+        for (int c = 0; c < QOS_CLASSES; c++) {
+            wrr->credit[c] = cfg[c].weight;
+        }
+    }
+    return first;
+}
+
+void qos_queued(qos_class_t cls)
+{
+    unsigned irq_state = disableIRQ();
+    stats[cls].queued++;
+    restoreIRQ(irq_state);
+}
+
+void qos_dropped(qos_class_t cls)
+{
+    unsigned irq_state = disableIRQ();
+    stats[cls].dropped++;
+    restoreIRQ(irq_state);
+}
+
+void qos_sent(qos_class_t cls, timex_t since)
+{
+    timex_t now;
+
+    vtimer_now(&now);
+    uint64_t us = timex_uint64(timex_sub(now, since));
+
+    unsigned irq_state = disableIRQ();
+    stats[cls].sent++;
+    stats[cls].lat_sum += us;
+    if (us > stats[cls].lat_max) {
+        stats[cls].lat_max = (us > UINT32_MAX) ? UINT32_MAX : (uint32_t) us;
+    }
+    restoreIRQ(irq_state);
+}
+
+void qos_stats(qos_class_t cls, qos_stats_t *out, int reset)
+{
+    unsigned irq_state = disableIRQ();
+    *out = stats[cls];
+    if (reset) {
+        memset(&stats[cls], 0, sizeof(stats[cls]));
+    }
+    restoreIRQ(irq_state);
+}
+
+const char *qos_class_str(qos_class_t cls)
+{
+    return class_str[cls];
+}
+
+int qos_class_parse(const char *str, qos_class_t *cls)
+{
+    for (int i = 0; i < QOS_CLASSES; i++) {
+        if (strcmp(str, class_str[i]) == 0) {
+            *cls = (qos_class_t) i;
+            return 0;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief Traffic classes of the router
+ *
+ * Datagrams for the appserver and gateway requests are queued per class, so
+ * that an alarm does not wait behind bulk traffic. A class is assigned
+ *
+ *  - by the UDP source port, if there is a rule for it
+ *  - by the name of a gateway request or of a datagram holding a name, if
+ *    there is a rule for a prefix of it
+ *  - else by the events of a datagram: ALARM is QOS_ALARM, other events
+ *    QOS_NORMAL and anything else QOS_BULK; gateway requests are QOS_NORMAL
+ *
+ * Queues are served by strict priority, or round robin weighted per class.
+ * Each class has its own queue limit and drops either the new or the oldest
+ * datagram when that is reached. The counters cover both the UDP bridge and
+ * the gateway, latency is the time from reception to the hand over to the
+ * appserver, or to the answer of a gateway request.
+ *
+ * @}
+ */
+
+#ifndef QOS_H
+#define QOS_H
+
+#include <stdint.h>
+
+#include "vtimer.h"
+
+/** longest queue of a class */
+#define QOS_QUEUE_MAX       (4)
+#define QOS_RULES           (8)
+#define QOS_PREFIX_LEN      (32)
+
+typedef enum {
+    QOS_ALARM,
+    QOS_NORMAL,
+    QOS_BULK,
+    QOS_CLASSES
+} qos_class_t;
+
+typedef enum {
+    QOS_STRICT,
+    QOS_WEIGHTED
+} qos_sched_t;
+
+typedef enum {
+    QOS_DROP_TAIL,          /**< drop what arrives at a full queue */
+    QOS_DROP_HEAD           /**< drop the oldest to make room */
+} qos_drop_t;
+
+typedef struct {
+    unsigned limit;         /**< up to QOS_QUEUE_MAX */
+    qos_drop_t drop;
+    unsigned weight;        /**< turns per round if weighted */
+} qos_class_cfg_t;
+
+typedef struct {
+    uint32_t queued;
+    uint32_t sent;
+    uint32_t dropped;
+    uint32_t lat_max;       /**< in us */
+    uint64_t lat_sum;
+} qos_stats_t;
+
+/** round robin state of a scheduler, zero to start */
+typedef struct {
+    unsigned credit[QOS_CLASSES];
+} qos_wrr_t;
+
+/**
+ * @brief add a rule for a name prefix, replacing one for the same prefix
+ *
+ * @return 0 on success, -1 if the prefix is too long or all rules are taken
+ */
+int qos_rule_prefix(const char *prefix, qos_class_t cls);
+
+/**
+ * @brief add a rule for a UDP source port, replacing one for the same port
+ *
+ * @return 0 on success, -1 if all rules are taken
+ */
+int qos_rule_port(uint16_t port, qos_class_t cls);
+
+/**
+ * @brief class of the longest matching prefix rule, @p dflt if there is none
+ */
+qos_class_t qos_class_name(const char *name, qos_class_t dflt);
+
+/**
+ * @brief class of a source port rule, @p dflt if there is none
+ */
+qos_class_t qos_class_port(uint16_t port, qos_class_t dflt);
+
+void qos_set_sched(qos_sched_t sched);
+
+qos_sched_t qos_get_sched(void);
+
+/**
+ * @brief set queue limit, drop policy and weight of a class
+ *
+ * @return 0 on success, -1 if the limit exceeds QOS_QUEUE_MAX
+ */
+int qos_set_class(qos_class_t cls, const qos_class_cfg_t *cfg);
+
+void qos_get_class(qos_class_t cls, qos_class_cfg_t *cfg);
+
+/**
+ * @brief pick the class to serve next
+ *
+ * @param[in] backlog   queued entries per class
+ *
+ * @return the class, -1 if nothing is queued
+ */
+int qos_pick(qos_wrr_t *wrr, const unsigned backlog[QOS_CLASSES]);
+
+void qos_queued(qos_class_t cls);
+
+void qos_dropped(qos_class_t cls);
+
+/**
+ * @brief count an entry as served, received at @p since
+ */
+void qos_sent(qos_class_t cls, timex_t since);
+
+void qos_stats(qos_class_t cls, qos_stats_t *stats, int reset);
+
+const char *qos_class_str(qos_class_t cls);
+
+/**
+ * @brief parse "alarm", "normal" or "bulk"
+ *
+ * @return 0 on success, -1 on an unknown class
+ */
+int qos_class_parse(const char *str, qos_class_t *cls);
+
+#endif /* QOS_H */
@@ -13,6 +13,8 @@
 #include <inttypes.h>
 
 #include "thread.h"
+#include "irq.h"
+#include "vtimer.h"
 
 #include "socket_base/socket.h"
 
@@ -22,17 +24,52 @@
 #include "ccn_lite/ccnl-riot.h"
 
 #include "demo.h"
+#include "counters.h"
+#include "prefetch.h"
+#include "qos.h"
+#include "../events.h"
+#include "../evt_codec.h"
 
 #define UDP_BUFFER_SIZE     (128)
 #define SERVER_PORT     (0xFF01)
 
+/* receive buffers, a datagram keeps its buffer until the appserver is done:
+ * the queues of all classes, the one the appserver holds and the one being
+ * received into */
+#define UDP_POOL_SIZE       (QOS_CLASSES * QOS_QUEUE_MAX + 2)
+/* wake ups for the bridge, a power of two */
+#define UDP_WAKEUPS         (2)
+
+#define MSG_UDP_BRIDGE      (0x5401)
+
+typedef struct {
+    riot_ccnl_msg_t rmsg;
+    qos_class_t cls;
+    timex_t arrived;
+    char data[UDP_BUFFER_SIZE + 1];     /* null terminated for printing */
+} udp_buf_t;
+
 char udp_server_stack_buffer[KERNEL_CONF_STACKSIZE_MAIN];
+char udp_bridge_stack_buffer[KERNEL_CONF_STACKSIZE_MAIN];
 char addr_str[IPV6_MAX_ADDR_STR_LEN];
-char buffer_main[UDP_BUFFER_SIZE];
+
+static udp_buf_t pool[UDP_POOL_SIZE];
+static udp_buf_t *pool_free[UDP_POOL_SIZE];
+static unsigned pool_avail;
+
+static msg_t bridge_queue[UDP_WAKEUPS];
+static int udp_bridge_pid;
+
+/* datagrams waiting for the appserver, per class */
+static udp_buf_t *queue[QOS_CLASSES][QOS_QUEUE_MAX];
+static unsigned queue_head[QOS_CLASSES];
+static unsigned queue_len[QOS_CLASSES];
+static qos_wrr_t bridge_wrr;
 
 extern int appserver_pid;
 
 static void *init_udp_server(void *);
+static void *udp_bridge(void *);
 
 /* UDP server thread */
 void udp_server(int argc, char **argv)
@@ -40,6 +77,15 @@ void udp_server(int argc, char **argv)
     (void) argc;
     (void) argv;
 
+    for (pool_avail = 0; pool_avail < UDP_POOL_SIZE; pool_avail++) {
+        pool_free[pool_avail] = &pool[pool_avail];
+    }
+
+    udp_bridge_pid = thread_create(
+            udp_bridge_stack_buffer, sizeof(udp_bridge_stack_buffer),
+            PRIORITY_MAIN, CREATE_STACKTEST,
+            udp_bridge, NULL, "udp_bridge");
+
     int udp_server_thread_pid = thread_create(
             udp_server_stack_buffer, sizeof(udp_server_stack_buffer),
             PRIORITY_MAIN, CREATE_STACKTEST,
@@ -47,8 +93,134 @@ void udp_server(int argc, char **argv)
     printf("UDP SERVER ON PORT %d (THREAD PID: %d)\n", HTONS(SERVER_PORT), udp_server_thread_pid);
 }
 
-msg_t m;
-riot_ccnl_msg_t rmsg;
+static udp_buf_t *udp_buf_get(void)
+{
+    udp_buf_t *buf = NULL;
+
+    unsigned irq_state = disableIRQ();
+    if (pool_avail) {
+        buf = pool_free[--pool_avail];
+    }
+    restoreIRQ(irq_state);
+    return buf;
+}
+
+static void udp_buf_put(udp_buf_t *buf)
+{
+    unsigned irq_state = disableIRQ();
+    pool_free[pool_avail++] = buf;
+    restoreIRQ(irq_state);
+}
+
+/*
+ * Queue a datagram in its class, or drop it or the oldest of the class if
+ * the queue is full. Returns 0 if the datagram itself was dropped.
+ */
+static int udp_enqueue(udp_buf_t *buf)
+{
+    qos_class_cfg_t cfg;
+    udp_buf_t *victim = NULL;
+    qos_class_t c = buf->cls;
+
+    qos_get_class(c, &cfg);
+
+    unsigned irq_state = disableIRQ();
+    if (queue_len[c] >= cfg.limit) {
+        if (cfg.drop == QOS_DROP_HEAD && queue_len[c]) {
+            victim = queue[c][queue_head[c]];
+            queue_head[c] = (queue_head[c] + 1) % QOS_QUEUE_MAX;
+            queue_len[c]--;
+        }
+        else {
+            victim = buf;
+        }
+    }
+    if (victim != buf) {
+        queue[c][(queue_head[c] + queue_len[c]) % QOS_QUEUE_MAX] = buf;
+        queue_len[c]++;
+    }
+    restoreIRQ(irq_state);
+
+    if (victim) {
+        counters_inc(CNT_DROP);
+        qos_dropped(c);
+        udp_buf_put(victim);
+    }
+    if (victim != buf) {
+        qos_queued(c);
+        return 1;
+    }
+    return 0;
+}
+
+static udp_buf_t *udp_dequeue(void)
+{
+    udp_buf_t *buf = NULL;
+
+    unsigned irq_state = disableIRQ();
+    int c = qos_pick(&bridge_wrr, queue_len);
+    if (c >= 0) {
+        buf = queue[c][queue_head[c]];
+        queue_head[c] = (queue_head[c] + 1) % QOS_QUEUE_MAX;
+        queue_len[c]--;
+    }
+    restoreIRQ(irq_state);
+    return buf;
+}
+
+/* class of a datagram without a rule for its source port, see qos.h */
+static qos_class_t udp_classify(const char *data, const cmd_t *cmds, int n)
+{
+    if (n <= 0) {
+        return (data[0] == '/') ? qos_class_name(data, QOS_BULK) : QOS_BULK;
+    }
+    for (int i = 0; i < n; i++) {
+        if (cmds[i].id == ALARM) {
+            return QOS_ALARM;
+        }
+    }
+    return QOS_NORMAL;
+}
+
+/*
+ * Hands the datagrams to the appserver one at a time. The appserver has no
+ * message queue, so msg_send() returns only once it is back in msg_receive(),
+ * i.e. done with the datagram before. That is when its buffer is freed.
+ */
+static void *udp_bridge(void *arg)
+{
+    (void) arg;
+
+    msg_t in, out;
+    udp_buf_t *buf, *held = NULL;
+
+    msg_init_queue(bridge_queue, UDP_WAKEUPS);
+
+    while (1) {
+        /* a wake up may stand for more than one datagram */
+        msg_receive(&in);
+
+        while ((buf = udp_dequeue()) != NULL) {
+            printf("relaying to appserver at PID %i\n", appserver_pid);
+            out.type = UPPER_LAYER_4;
+            out.content.ptr = (char *) &buf->rmsg;
+            if (msg_send(&out, appserver_pid) != 1) {
+                counters_inc(CNT_DROP);
+                qos_dropped(buf->cls);
+                udp_buf_put(buf);
+                continue;
+            }
+            qos_sent(buf->cls, buf->arrived);
+
+            if (held) {
+                udp_buf_put(held);
+            }
+            held = buf;
+        }
+    }
+
+    return NULL;
+}
 
 static void *init_udp_server(void *arg)
 {
@@ -57,6 +229,8 @@ static void *init_udp_server(void *arg)
     sockaddr6_t sa;
     int32_t recsize;
     uint32_t fromlen;
+    msg_t m;
+    char scratch[UDP_BUFFER_SIZE + 1];
     int sock = socket_base_socket(PF_INET6, SOCK_DGRAM, IPPROTO_UDP);
 
     memset(&sa, 0, sizeof(sa));
@@ -72,20 +246,62 @@ static void *init_udp_server(void *arg)
     }
 
     while (1) {
-        recsize = socket_base_recvfrom(sock, (void *)buffer_main, UDP_BUFFER_SIZE, 0,
+        /* with the pool exhausted, the datagram is read and dropped */
+        udp_buf_t *buf = udp_buf_get();
+        char *data = buf ? buf->data : scratch;
+
+        recsize = socket_base_recvfrom(sock, (void *) data, UDP_BUFFER_SIZE, 0,
                                           &sa, &fromlen);
 
         if (recsize < 0) {
             printf("ERROR: recsize < 0!\n");
+            if (buf) {
+                udp_buf_put(buf);
+            }
+            continue;
+        }
+        counters_inc(CNT_UDP_IN);
+        data[recsize] = '\0';
+        if (buf) {
+            vtimer_now(&buf->arrived);
         }
 
-        printf("UDP packet of size %" PRIi32 " received, payload: %s\n", recsize, buffer_main);
-        printf("relaying to appserver at PID %i\n", appserver_pid);
-        m.type = UPPER_LAYER_4;
-        rmsg.size = recsize;
-        rmsg.payload = buffer_main;
-        m.content.ptr = (char *) &rmsg;
-        msg_send(&m, appserver_pid);
+        cmd_t cmds[EVT_CODEC_MAX_BATCH];
+        uint16_t epoch;
+        int n = evt_decode((uint8_t *) data, recsize, &epoch, cmds, EVT_CODEC_MAX_BATCH);
+
+        if (n > 0) {
+            printf("UDP packet of size %" PRIi32 " received, %i event(s), epoch %u\n",
+                   recsize, n, epoch);
+            int warn = 0;
+            for (int i = 0; i < n; i++) {
+                printf("  event %u for %u, data %i, sequ %u\n", cmds[i].id, cmds[i].dst, cmds[i].data, cmds[i].sequ);
+                warn |= (cmds[i].id == WARN);
+            }
+            /* fetch what an alarm is going to ask for */
+            if (warn) {
+                prefetch_warn();
+            }
+        }
+        else {
+            printf("UDP packet of size %" PRIi32 " received, payload: %s\n", recsize, data);
+        }
+
+        if (!buf) {
+            counters_inc(CNT_POOL_EMPTY);
+            counters_inc(CNT_DROP);
+            continue;
+        }
+
+        buf->rmsg.size = recsize;
+        buf->rmsg.payload = buf->data;
+        buf->cls = qos_class_port(NTOHS(sa.sin6_port), udp_classify(data, cmds, n));
+        if (udp_enqueue(buf)) {
+            /* the bridge is awake already if its queue is full */
+            m.type = MSG_UDP_BRIDGE;
+            m.content.ptr = NULL;
+            msg_try_send(&m, udp_bridge_pid);
+        }
     }
 
     socket_base_close(sock);
@@ -101,17 +317,28 @@ void udp_send(int argc, char **argv)
     ipv6_addr_t ipaddr;
     int bytes_sent;
     int address;
-    char text[5];
+    cmd_t cmd;
+    uint8_t frame[EVT_CODEC_FRAME_LEN(1)];
+    static uint8_t sequ = 0;
+    static uint16_t epoch = 0;
 
-    if (argc != 3) {
-        printf("usage: send <addr> <text>\n");
+    if (argc < 3) {
+        printf("usage: send <addr> <event> [<data>]\n");
         return;
     }
 
     address = atoi(argv[1]);
 
-    strncpy(text, argv[2], sizeof(text));
-    text[sizeof(text) - 1] = 0;
+    cmd.dst = address;
+    cmd.id = (evt_t) atoi(argv[2]);
+    cmd.data = (argc > 3) ? atoi(argv[3]) : 0;
+    cmd.sequ = sequ++;
+    if (!epoch) {
+        timex_t now;
+        vtimer_now(&now);
+        epoch = evt_epoch((uint32_t) timex_uint64(now));
+    }
+    int frame_len = evt_encode(&cmd, 1, epoch, frame, sizeof(frame));
 
     sock = socket_base_socket(PF_INET6, SOCK_DGRAM, IPPROTO_UDP);
 
@@ -128,8 +355,7 @@ void udp_send(int argc, char **argv)
     memcpy(&sa.sin6_addr, &ipaddr, 16);
     sa.sin6_port = HTONS(SERVER_PORT);
 
-    bytes_sent = socket_base_sendto(sock, (char *)text,
-                                       strlen(text) + 1, 0, &sa,
+    bytes_sent = socket_base_sendto(sock, (char *)frame, frame_len, 0, &sa,
                                        sizeof(sa));
 
     if (bytes_sent < 0) {
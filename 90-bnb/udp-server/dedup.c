@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief       Per-source duplicate suppression for received events
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "dedup.h"
+
+/* how far to probe for a free slot before evicting */
+#define DEDUP_MAX_PROBE     (8)
+
+typedef struct {
+    uint16_t src;
+    uint8_t used;
+    uint8_t top;            /* highest sequence number seen */
+    uint16_t epoch;         /* epoch the window belongs to */
+    uint16_t prev_epoch;    /* the one before, 0 if none */
+    uint32_t bitmap;        /* bit i set: top - i has been seen */
+} dedup_entry_t;
+
+static dedup_entry_t table[DEDUP_MAX_SOURCES];
+static dedup_stats_t stats;
+
+static unsigned dedup_hash(uint16_t src)
+{
+    /* node ids are mostly small and consecutive, spread them anyway */
+    return ((src * 40503U) >> 4) & (DEDUP_MAX_SOURCES - 1);
+}
+
+static dedup_entry_t *dedup_lookup(uint16_t src)
+{
+    unsigned home = dedup_hash(src);
+
+    for (unsigned i = 0; i < DEDUP_MAX_PROBE; i++) {
+        dedup_entry_t *e = &table[(home + i) & (DEDUP_MAX_SOURCES - 1)];
+        if (e->used && e->src == src) {
+            stats.hits++;
+            return e;
+        }
+        if (!e->used) {
+            stats.misses++;
+            e->used = 1;
+            e->src = src;
+            e->bitmap = 0;
+            e->prev_epoch = 0;
+            return e;
+        }
+    }
+
+    /* no space left in the neighborhood, reuse the home slot */
+    dedup_entry_t *e = &table[home];
+    stats.misses++;
+    stats.evicted++;
+    e->src = src;
+    e->bitmap = 0;
+    e->prev_epoch = 0;
+    return e;
+}
+
+int dedup_check(uint16_t src, uint16_t epoch, uint8_t sequ)
+{
+    dedup_entry_t *e = dedup_lookup(src);
+
+    if (e->bitmap && epoch == e->prev_epoch) {
+        /* sent before the source restarted */
+        stats.stale++;
+        return 0;
+    }
+    if (e->bitmap == 0 || epoch != e->epoch) {
+        /* first event of this source, or the first since it restarted */
+        if (e->bitmap) {
+            stats.resets++;
+            e->prev_epoch = e->epoch;
+        }
+        e->epoch = epoch;
+        e->top = sequ;
+        e->bitmap = 1;
+        stats.accepted++;
+        return 1;
+    }
+
+    /* sequence numbers wrap, so compare them as a signed difference */
+    int8_t delta = (int8_t)(sequ - e->top);
+
+    if (delta > 0) {
+        e->bitmap = (delta >= DEDUP_WINDOW) ? 0 : e->bitmap << delta;
+        e->bitmap |= 1;
+        e->top = sequ;
+    }
+    else if (-delta >= DEDUP_WINDOW) {
+        /* too old to tell, a restart would have come with a new epoch */
+        stats.stale++;
+        return 0;
+    }
+    else if (e->bitmap & (1UL << -delta)) {
+        stats.dropped++;
+        return 0;
+    }
+    else {
+        e->bitmap |= (1UL << -delta);
+    }
+
+    stats.accepted++;
+    return 1;
+}
+
+void dedup_get_stats(dedup_stats_t *s)
+{
+    *s = stats;
+}
+
+void dedup_reset(void)
+{
+    memset(table, 0, sizeof(table));
+    memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2014 INRIA
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser General
+ * Public License. See the file LICENSE in the top level directory for more
+ * details.
+ */
+
+/**
+ * @ingroup examples
+ * @{
+ *
+ * @file
+ * @brief       Per-source duplicate suppression for received events
+ *
+ * Every source gets a sliding window of DEDUP_WINDOW sequence numbers,
+ * stored as a bitmap next to the highest sequence number seen so far.
+ * Sources are identified by the last 16 bit of their IPv6 address and kept
+ * in a fixed-size hash table, so memory use does not depend on the number
+ * of nodes in the network.
+ *
+ * Events too far behind the window are dropped as stale. A source that
+ * restarted is recognised by the new epoch in its frames (see evt_codec.h),
+ * which restarts its window. Frames of the epoch before that are dropped
+ * as stale, however late they arrive. Only one old epoch is remembered per
+ * source.
+ *
+ * @}
+ */
+
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include <stdint.h>
+
+/** number of sources tracked, has to be a power of two */
+#define DEDUP_MAX_SOURCES   (256)
+/** size of the window in sequence numbers */
+#define DEDUP_WINDOW        (32)
+
+/**
+ * @brief   Counters of the duplicate filter
+ */
+typedef struct {
+    uint32_t accepted;      /**< events passed on */
+    uint32_t dropped;       /**< duplicates dropped */
+    uint32_t stale;         /**< events dropped for being behind the window */
+    uint32_t hits;          /**< lookups that found the source */
+    uint32_t misses;        /**< lookups for unknown sources */
+    uint32_t evicted;       /**< sources replaced because the table was full */
+    uint32_t resets;        /**< windows restarted by a new epoch */
+} dedup_stats_t;
+
+/**
+ * @brief   Check an event against the window of its source
+ *
+ * @param[in] src       source address, last 16 bit of the IPv6 address
+ * @param[in] epoch     epoch of the source, from the frame of the event
+ * @param[in] sequ      sequence number of the event
+ *
+ * @return  1 if the event is new, 0 if it is a duplicate or stale
+ */
+int dedup_check(uint16_t src, uint16_t epoch, uint8_t sequ);
+
+/**
+ * @brief   Get a copy of the counters
+ */
+void dedup_get_stats(dedup_stats_t *stats);
+
+/**
+ * @brief   Forget all sources and reset the counters
+ */
+void dedup_reset(void);
+
+#endif /* DEDUP_H */
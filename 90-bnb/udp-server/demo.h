@@ -28,6 +28,7 @@ void rpl_udp_dodag(int argc, char **argv);
 /* UDP shell command handlers */
 void udp_server(int argc, char **argv);
 void udp_send(int argc, char **argv);
+void udp_dupstat(int argc, char **argv);
 
 /* helper command handlers */
 void rpl_udp_ip(int argc, char **argv);
@@ -38,6 +38,7 @@ static const shell_command_t sc[] = {
     { "set", "Set ID", rpl_udp_set_id},
     { "server", "Starts a UDP server", udp_server},
     { "send", "Send a UDP datagram", udp_send},
+    { "dupstat", "Duplicate filter statistics [reset]", udp_dupstat},
     { "ign", "ignore node", rpl_udp_ignore},
     { "dodag", "Shows the dodag", rpl_udp_dodag},
     { NULL, NULL, NULL }
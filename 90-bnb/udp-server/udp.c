@@ -13,6 +13,7 @@
 #include <inttypes.h>
 
 #include "thread.h"
+#include "vtimer.h"
 
 #include "destiny/socket.h"
 
@@ -20,6 +21,8 @@
 
 #include "demo.h"
 #include "../events.h"
+#include "../evt_codec.h"
+#include "dedup.h"
 
 #define UDP_BUFFER_SIZE     (128)
 #define SERVER_PORT     (0xFF01)
@@ -44,7 +47,9 @@ void udp_server(int argc, char **argv)
     printf("UDP SERVER ON PORT %d (THREAD PID: %d)\n", HTONS(SERVER_PORT), udp_server_thread_pid);
 }
 
-static void inet_request(uint8_t src, char *req)
+/* a plain text datagram, reported the way all datagrams were before events
+ * were encoded */
+static void inet_request_text(uint8_t src)
 {
     uint8_t payload;
 
@@ -57,6 +62,16 @@ static void inet_request(uint8_t src, char *req)
     printf("bw %u %u web\n", id, payload);
 }
 
+/* an event: from the sender to us, on to its destination and to the web
+ * frontend, which gets its data and sequence number as well */
+static void inet_request(uint8_t src, const cmd_t *cmd)
+{
+    // bw sender event receiver
+    printf("bw %u %u %u\n", src, cmd->id, id);
+    printf("bw %u %u %u\n", id, cmd->id, cmd->dst);
+    printf("bw %u %u web %i %u\n", id, cmd->id, cmd->data, cmd->sequ);
+}
+
 static void *init_udp_server(void *arg)
 {
     (void) arg;
@@ -87,9 +102,34 @@ static void *init_udp_server(void *arg)
             printf("ERROR: recsize < 0!\n");
         }
 
-        printf("UDP packet received from %s, payload: %s\n", ipv6_addr_to_str(addr_str, IPV6_MAX_ADDR_STR_LEN, &sa.sin6_addr), buffer_main);
-
-        inet_request(sa.sin6_addr.uint8[15], buffer_main);
+        uint8_t src = sa.sin6_addr.uint8[15];
+        uint16_t src_addr = (sa.sin6_addr.uint8[14] << 8) | src;
+        cmd_t cmds[EVT_CODEC_MAX_BATCH];
+        uint16_t epoch;
+        int n = evt_decode((uint8_t *) buffer_main, recsize, &epoch, cmds, EVT_CODEC_MAX_BATCH);
+
+        if (n > 0) {
+            int fresh = 0;
+
+            printf("UDP packet received from %s, %i event(s)\n", ipv6_addr_to_str(addr_str, IPV6_MAX_ADDR_STR_LEN, &sa.sin6_addr), n);
+            for (int i = 0; i < n; i++) {
+                /* retransmissions must not trigger the request twice */
+                if (!dedup_check(src_addr, epoch, cmds[i].sequ)) {
+                    printf("  duplicate or stale sequ %u dropped\n", cmds[i].sequ);
+                    continue;
+                }
+                printf("  event %u for %u, data %i, sequ %u\n", cmds[i].id, cmds[i].dst, cmds[i].data, cmds[i].sequ);
+                inet_request(src, &cmds[i]);
+                fresh++;
+            }
+            if (!fresh) {
+                continue;
+            }
+        }
+        else {
+            printf("UDP packet received from %s, payload: %s\n", ipv6_addr_to_str(addr_str, IPV6_MAX_ADDR_STR_LEN, &sa.sin6_addr), buffer_main);
+            inet_request_text(src);
+        }
 
         printf("replying\n");
         sa.sin6_port = HTONS(SERVER_PORT);
@@ -110,17 +150,28 @@ void udp_send(int argc, char **argv)
     ipv6_addr_t ipaddr;
     int bytes_sent;
     int address;
-    char text[5];
+    cmd_t cmd;
+    uint8_t frame[EVT_CODEC_FRAME_LEN(1)];
+    static uint8_t sequ = 0;
+    static uint16_t epoch = 0;
 
-    if (argc != 3) {
-        printf("usage: send <addr> <text>\n");
+    if (argc < 3) {
+        printf("usage: send <addr> <event> [<data>]\n");
         return;
     }
 
     address = atoi(argv[1]);
 
-    strncpy(text, argv[2], sizeof(text));
-    text[sizeof(text) - 1] = 0;
+    cmd.dst = address;
+    cmd.id = (evt_t) atoi(argv[2]);
+    cmd.data = (argc > 3) ? atoi(argv[3]) : 0;
+    cmd.sequ = sequ++;
+    if (!epoch) {
+        timex_t now;
+        vtimer_now(&now);
+        epoch = evt_epoch((uint32_t) timex_uint64(now));
+    }
+    int frame_len = evt_encode(&cmd, 1, epoch, frame, sizeof(frame));
 
     sock = destiny_socket(PF_INET6, SOCK_DGRAM, IPPROTO_UDP);
 
@@ -137,8 +188,7 @@ void udp_send(int argc, char **argv)
     memcpy(&sa.sin6_addr, &ipaddr, 16);
     sa.sin6_port = HTONS(SERVER_PORT);
 
-    bytes_sent = destiny_socket_sendto(sock, (char *)text,
-                                       strlen(text) + 1, 0, &sa,
+    bytes_sent = destiny_socket_sendto(sock, (char *)frame, frame_len, 0, &sa,
                                        sizeof(sa));
 
     if (bytes_sent < 0) {
@@ -152,3 +202,21 @@ void udp_send(int argc, char **argv)
 
     destiny_socket_close(sock);
 }
+
+/* duplicate filter statistics command */
+void udp_dupstat(int argc, char **argv)
+{
+    dedup_stats_t stats;
+
+    if ((argc > 1) && !strcmp(argv[1], "reset")) {
+        dedup_reset();
+        puts("duplicate filter reset");
+        return;
+    }
+
+    dedup_get_stats(&stats);
+    printf("accepted %" PRIu32 ", dropped %" PRIu32 ", stale %" PRIu32 "\n",
+           stats.accepted, stats.dropped, stats.stale);
+    printf("sources: hits %" PRIu32 ", misses %" PRIu32 ", evicted %" PRIu32 ", resets %" PRIu32 "\n",
+           stats.hits, stats.misses, stats.evicted, stats.resets);
+}